@@ -0,0 +1,49 @@
+#include "backdoor_bus.h"
+
+#include "tracer.h"
+#include "verilator_context.h"
+#include "Vtop___024root.h"
+
+#include <stdexcept>
+
+namespace tt09_levenshtein
+{
+
+BackdoorBus::BackdoorBus(Bus& bus, VerilatorContext& context) noexcept
+    : m_bus(bus)
+    , m_context(context)
+{
+}
+
+asio::awaitable<void> BackdoorBus::read(std::uint32_t address, std::span<std::byte> buffer)
+{
+    co_await m_bus.read(address, buffer);
+}
+
+asio::awaitable<void> BackdoorBus::write(std::uint32_t address, std::span<const std::byte> data)
+{
+    co_await m_bus.write(address, data);
+}
+
+asio::awaitable<void> BackdoorBus::load(std::uint32_t address, std::span<const std::byte> data)
+{
+    if (address < RegisterSpaceSize)
+    {
+        co_await m_bus.load(address, data);
+        co_return;
+    }
+    if (address >= MemorySize || data.size() > MemorySize - address)
+    {
+        throw std::out_of_range("Load exceeds SRAM size");
+    }
+
+    AsyncTraceScope scope("bus", "backdoor");
+
+    auto& memory = m_context.top().rootp->top__DOT__pmod_sram__DOT__memory;
+    for (auto value : data)
+    {
+        memory[address++] = std::to_integer<std::uint8_t>(value);
+    }
+}
+
+} // namespace tt09_levenshtein
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "bus.h"
+
+#include <cstdint>
+
+namespace tt09_levenshtein
+{
+
+class VerilatorContext;
+
+// Bus loading memory images straight into the storage of the QSPI SRAM model in the Verilator top
+//
+// Only bulk loads take the backdoor. Reads and regular writes go through the wrapped bus, so the device still sees
+// every other transaction. The model is attached to CS, so the client must select that chip.
+class BackdoorBus : public Bus
+{
+public:
+    BackdoorBus(Bus& bus, VerilatorContext& context) noexcept;
+
+    asio::awaitable<void> read(std::uint32_t address, std::span<std::byte> buffer) override;
+    asio::awaitable<void> write(std::uint32_t address, std::span<const std::byte> data) override;
+    asio::awaitable<void> load(std::uint32_t address, std::span<const std::byte> data) override;
+
+private:
+    // Addresses below this are decoded as registers by the interconnect
+    static constexpr std::uint32_t RegisterSpaceSize = 0x000020;
+    static constexpr std::uint32_t MemorySize = 0x1000000;
+
+    Bus& m_bus;
+    VerilatorContext& m_context;
+};
+
+} // namespace tt09_levenshtein
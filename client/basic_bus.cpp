@@ -1,5 +1,7 @@
 #include "basic_bus.h"
 
+#include "tracer.h"
+
 #include <stdexcept>
 
 namespace tt09_levenshtein
@@ -38,6 +40,8 @@ asio::awaitable<std::byte> BasicBus::execute(Operation operation, std::uint32_t
         throw std::invalid_argument("Address out of range");
     }
 
+    AsyncTraceScope scope("bus", operation == Operation::Write ? "write" : "read");
+
     std::uint32_t command = (operation == Operation::Write ? 0x80000000 : 0) | (address << 8) | std::to_integer<std::uint8_t>(value);
 
     co_return co_await execute(command);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace tt09_levenshtein
+{
+
+// Framing helpers shared by the socket protocols, for frames of std::uint8_t or std::byte
+
+template<typename Byte, std::size_t Extent>
+std::uint64_t readBigEndian(std::span<Byte, Extent> bytes) noexcept
+{
+    std::uint64_t value = 0;
+    for (auto byte : bytes)
+    {
+        value = (value << 8) | static_cast<std::uint8_t>(byte);
+    }
+    return value;
+}
+
+template<typename Byte>
+void appendBigEndian(std::vector<Byte>& frame, std::uint64_t value, std::size_t size)
+{
+    for (std::size_t i = size; i != 0; --i)
+    {
+        frame.push_back(static_cast<Byte>(static_cast<std::uint8_t>(value >> ((i - 1) * 8))));
+    }
+}
+
+} // namespace tt09_levenshtein
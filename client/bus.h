@@ -16,6 +16,12 @@ public:
 
     virtual asio::awaitable<void> read(std::uint32_t address, std::span<std::byte> buffer) = 0;
     virtual asio::awaitable<void> write(std::uint32_t address, std::span<const std::byte> data) = 0;
+
+    // Bulk load of memory contents. Buses with a faster path than regular writes for large images override this
+    virtual asio::awaitable<void> load(std::uint32_t address, std::span<const std::byte> data)
+    {
+        co_await write(address, data);
+    }
 };
 
 } // namespace tt09_levenshtein
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "bus_server.h"
+
+#include "big_endian.h"
+#include "bus.h"
+#include "context.h"
+
+#include <asio/buffer.hpp>
+#include <asio/read.hpp>
+#include <asio/redirect_error.hpp>
+#include <asio/this_coro.hpp>
+#include <asio/use_awaitable.hpp>
+#include <asio/write.hpp>
+#include <fmt/format.h>
+
+#include <array>
+#include <chrono>
+#include <exception>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tt09_levenshtein
+{
+
+BusServer::BusServer(const Config& config, Bus& bus, Context& context)
+    : m_listener(config, "device")
+    , m_bus(bus)
+    , m_context(context)
+{
+}
+
+asio::awaitable<void> BusServer::run()
+{
+    co_await m_listener.run(
+        [this](auto socket)
+        {
+            return serve(std::move(socket));
+        });
+}
+
+template<typename Socket>
+asio::awaitable<void> BusServer::serve(Socket socket)
+{
+    co_await acquire();
+
+    try
+    {
+        std::vector<std::uint8_t> payload;
+        std::vector<std::uint8_t> frame;
+
+        while (true)
+        {
+            std::array<std::uint8_t, 9> header;
+            co_await asio::async_read(socket, asio::buffer(header), asio::use_awaitable);
+
+            auto command = static_cast<Command>(header[0]);
+            auto address = static_cast<std::uint32_t>(readBigEndian(std::span(header).subspan(1, 4)));
+            auto length = static_cast<std::uint32_t>(readBigEndian(std::span(header).subspan(5, 4)));
+            if (length > MaxPayloadSize)
+            {
+                // The stream can't be resynchronized after an oversized request
+                break;
+            }
+
+            payload.resize(command == Command::Read ? 0 : length);
+            co_await asio::async_read(socket, asio::buffer(payload), asio::use_awaitable);
+
+            auto status = Status::Ok;
+            std::vector<std::byte> data;
+            std::string message;
+            try
+            {
+                switch (command)
+                {
+                    case Command::Read:
+                        data.resize(length);
+                        co_await m_bus.read(address, data);
+                        break;
+
+                    case Command::Write:
+                        co_await m_bus.write(address, std::as_bytes(std::span(payload)));
+                        break;
+
+                    case Command::Load:
+                        co_await m_bus.load(address, std::as_bytes(std::span(payload)));
+                        break;
+
+                    case Command::Wait:
+                        if (payload.size() != 8)
+                        {
+                            throw std::invalid_argument("Wait takes a 64-bit time");
+                        }
+                        co_await m_context.wait(std::chrono::nanoseconds(readBigEndian(std::span(payload))));
+                        break;
+
+                    default:
+                        throw std::invalid_argument(fmt::format("Unknown command {}", static_cast<unsigned int>(command)));
+                }
+            }
+            catch (const std::exception& exception)
+            {
+                status = Status::Error;
+                message = exception.what();
+            }
+
+            auto body = status == Status::Ok
+                ? std::as_bytes(std::span(data))
+                : std::as_bytes(std::span(message.data(), message.size()));
+
+            frame.clear();
+            frame.push_back(static_cast<std::uint8_t>(status));
+            appendBigEndian(frame, static_cast<std::uint64_t>(m_context.now().count()), 8);
+            appendBigEndian(frame, body.size(), 4);
+            for (auto value : body)
+            {
+                frame.push_back(std::to_integer<std::uint8_t>(value));
+            }
+
+            co_await asio::async_write(socket, asio::buffer(frame), asio::use_awaitable);
+        }
+    }
+    catch (const std::exception&)
+    {
+        // Connection closed
+    }
+
+    release();
+}
+
+asio::awaitable<void> BusServer::acquire()
+{
+    if (!m_busy)
+    {
+        m_busy = true;
+        co_return;
+    }
+
+    // The device is handed over by release(), which cancels the timer of the next waiting connection
+    asio::steady_timer timer(co_await asio::this_coro::executor, asio::steady_timer::time_point::max());
+    m_waiters.push_back(&timer);
+
+    asio::error_code ec;
+    co_await timer.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+}
+
+void BusServer::release()
+{
+    if (m_waiters.empty())
+    {
+        m_busy = false;
+        return;
+    }
+
+    m_waiters.front()->cancel();
+    m_waiters.pop_front();
+}
+
+} // namespace tt09_levenshtein
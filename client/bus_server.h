@@ -0,0 +1,67 @@
+#pragma once
+
+#include "listener.h"
+
+#include <asio/awaitable.hpp>
+#include <asio/steady_timer.hpp>
+
+#include <cstdint>
+#include <deque>
+
+namespace tt09_levenshtein
+{
+
+class Bus;
+class Context;
+
+// Exposes a device to client processes over a Unix domain socket and/or a TCP port on the loopback address
+//
+// A request is a command byte, a 32-bit big endian address, a 32-bit big endian length and, for Write, Load and
+// Wait, that many bytes of payload. Wait takes a 64-bit big endian number of nanoseconds. Every request is answered
+// with a status byte, the 64-bit big endian device time in nanoseconds, a 32-bit big endian length and that many
+// bytes: the data for Read and the message on error.
+//
+// A connection holds the device until it is closed, so the bus transactions of different clients are never
+// interleaved. Other connections wait for their turn.
+class BusServer
+{
+public:
+    enum class Command : std::uint8_t
+    {
+        Read = 0,
+        Write = 1,
+        Load = 2,
+        Wait = 3
+    };
+
+    enum class Status : std::uint8_t
+    {
+        Ok = 0,
+        Error = 1
+    };
+
+    using Config = Listener::Config;
+
+    // Longest payload accepted in a single request
+    static constexpr std::uint32_t MaxPayloadSize = 0x1000000;
+
+    BusServer(const Config& config, Bus& bus, Context& context);
+
+    // Serves until SIGINT or SIGTERM is received
+    asio::awaitable<void> run();
+
+private:
+    template<typename Socket>
+    asio::awaitable<void> serve(Socket socket);
+
+    asio::awaitable<void> acquire();
+    void release();
+
+    Listener m_listener;
+    Bus& m_bus;
+    Context& m_context;
+    bool m_busy = false;
+    std::deque<asio::steady_timer*> m_waiters;
+};
+
+} // namespace tt09_levenshtein
@@ -3,9 +3,12 @@
 #include "bit_vector.h"
 #include "bus.h"
 #include "context.h"
+#include "deletion_index.h"
+#include "query_cache.h"
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <map>
 #include <stdexcept>
@@ -14,6 +17,40 @@
 namespace tt09_levenshtein
 {
 
+namespace
+{
+
+// Closes the search gate however the search ends
+class SearchGateScope
+{
+public:
+    explicit SearchGateScope(const std::function<void(bool)>* gate)
+        : m_gate(gate)
+    {
+        if (m_gate)
+        {
+            (*m_gate)(true);
+        }
+    }
+
+    SearchGateScope(const SearchGateScope&) = delete;
+
+    ~SearchGateScope()
+    {
+        if (m_gate)
+        {
+            (*m_gate)(false);
+        }
+    }
+
+    SearchGateScope& operator=(const SearchGateScope&) = delete;
+
+private:
+    const std::function<void(bool)>* m_gate;
+};
+
+} // namespace
+
 Client::Client(Context& context, Bus& bus) noexcept
     : m_context(context)
     , m_bus(bus)
@@ -22,7 +59,11 @@ Client::Client(Context& context, Bus& bus) noexcept
 
 asio::awaitable<void> Client::init(ChipSelect memoryChipSelect, bool clearVectorMap)
 {
+    AsyncTraceScope scope("client", "init");
+    auto t1 = m_context.now();
+
     m_maxLength = static_cast<unsigned int>(co_await readByte(MaxLengthAddress)) + 1;
+    m_prefixStackDepth = co_await readByte(PrefixDepthAddress);
     m_bitvectorSize = ((m_maxLength + 7) / 8) * 8;
     if (m_bitvectorSize > 128)
     {
@@ -53,20 +94,91 @@ asio::awaitable<void> Client::init(ChipSelect memoryChipSelect, bool clearVector
   
     co_await writeByte(SRAMControlAddress, static_cast<std::uint8_t>(memoryChipSelect));
 
+    // The memory has to be selected first, so that the probe can tell SRAM from registers
+    m_hasWideRegisters = co_await probeWideRegisters();
+    m_vectorCacheSize = 0;
+    m_engineCount = 1;
+    m_hasFillEngine = false;
+    if (m_hasWideRegisters)
+    {
+        m_vectorCacheSize = co_await readByte(VectorCacheAddress);
+        m_engineCount = std::max<unsigned int>(co_await readByte(EnginesAddress), 1);
+        m_hasFillEngine = (co_await readByte(FillAddress) & FillEngineFlag) != 0;
+    }
+    if (m_engineCount > 1 && m_vectorCacheSize < m_maxLength)
+    {
+        throw std::runtime_error("Device with multiple engines has too small a vector cache");
+    }
+
     if (clearVectorMap)
     {
-        for (unsigned int i = 0; i != 256; ++i)
+        // Clearing the padding between vectors as well lets the map be cleared in one go
+        co_await fill(m_vectorMapAddress, 256 * m_bitvectorAlignment, 0x00);
+    }
+
+    m_phaseTimes.init += m_context.now() - t1;
+}
+
+asio::awaitable<void> Client::fill(std::uint32_t address, std::uint32_t length, std::uint8_t value)
+{
+    AsyncTraceScope scope("client", "fill");
+
+    if (length == 0)
+    {
+        co_return;
+    }
+
+    if (!m_hasFillEngine)
+    {
+        std::vector<std::byte> data(length, std::byte(value));
+        co_await m_bus.load(address, data);
+        co_return;
+    }
+
+    if (address > 0xFFFFFF || length > 0xFFFFFF)
+    {
+        throw std::out_of_range(fmt::format("Fill of {} bytes at 0x{:06x} is out of range", length, address));
+    }
+
+    // The command is written a byte at a time to the same register, and the last byte starts the fill
+    auto command = std::to_array<std::uint8_t>({
+        static_cast<std::uint8_t>(address >> 16),
+        static_cast<std::uint8_t>(address >> 8),
+        static_cast<std::uint8_t>(address),
+        static_cast<std::uint8_t>(length >> 16),
+        static_cast<std::uint8_t>(length >> 8),
+        static_cast<std::uint8_t>(length),
+        value
+    });
+    // The device refuses the command while the bus is busy, e.g. with a burst prefetched past the end of the dictionary
+    // after a search, and then reports it once FILL is read
+    while (true)
+    {
+        for (auto byte : command)
         {
-            for (unsigned int j = 0; j != m_bitvectorSize / 8; ++j)
-            {
-                co_await writeByte(m_vectorMapAddress + i * m_bitvectorAlignment + j, 0);
-            }
+            co_await writeByte(FillAddress, byte);
+        }
+
+        // Reading FILL clears the rejected flag, so only the first read tells whether the command was refused
+        auto status = co_await readByte(FillAddress);
+        auto rejected = (status & FillRejectedFlag) != 0;
+        while ((status & FillBusyFlag) != 0)
+        {
+            co_await m_context.wait(m_pollInterval);
+            status = co_await readByte(FillAddress);
+        }
+
+        if (!rejected)
+        {
+            break;
         }
     }
 }
 
 asio::awaitable<Client::Result> Client::search(std::string_view word)
 {
+    AsyncTraceScope scope("client", "search");
+
     if (word.size() > m_maxLength)
     {
         throw std::invalid_argument(fmt::format("Word \"{}\" exceeds {} characters", word, m_maxLength));
@@ -76,6 +188,29 @@ asio::awaitable<Client::Result> Client::search(std::string_view word)
         throw std::invalid_argument("Word is empty");
     }
 
+    ++m_searchCount;
+    SearchGateScope gateScope(m_searchGate && m_searchCount == m_gatedSearch ? &m_searchGate : nullptr);
+
+    // The index only has every word if it was set before the dictionary was loaded
+    if (m_index && m_index->size() == m_wordCount)
+    {
+        if (auto result = m_index->find(word))
+        {
+            co_return *result;
+        }
+    }
+
+    if (m_cache)
+    {
+        if (auto result = m_cache->find(m_dictionaryFingerprint, word))
+        {
+            result->source = Source::Cache;
+            co_return *result;
+        }
+    }
+
+    auto t1 = m_context.now();
+
     // Verify accelerator is idle
 
     auto ctrl = co_await readByte(ControlAddress);
@@ -109,20 +244,46 @@ asio::awaitable<Client::Result> Client::search(std::string_view word)
         vectorMap[static_cast<std::uint8_t>(c)] = vector;
     }
 
-    // Write bitvectors
+    // Write bitvectors. When the engine can hold them all, they are streamed into its cache and SRAM is left untouched
 
-    for (auto [c, vector] : vectorMap)
+    bool useVectorCache = vectorMap.size() <= m_vectorCacheSize;
+    if (useVectorCache)
     {
-        co_await m_bus.write(m_vectorMapAddress + static_cast<std::uint32_t>(c) * m_bitvectorAlignment, std::as_bytes(vector.data()));
+        for (auto [c, vector] : vectorMap)
+        {
+            co_await writeByte(VectorCacheAddress, c);
+            for (auto value : vector.data())
+            {
+                co_await writeByte(VectorCacheAddress, value);
+            }
+        }
+    }
+    else
+    {
+        for (auto [c, vector] : vectorMap)
+        {
+            co_await m_bus.write(m_vectorMapAddress + static_cast<std::uint32_t>(c) * m_bitvectorAlignment, std::as_bytes(vector.data()));
+        }
     }
 
     // Initiate search
 
-    co_await writeByte(ControlAddress, EnableFlag);
+    std::uint8_t control = EnableFlag;
+    if (m_frontCodedDictionary)
+    {
+        control |= PrefixFlag;
+    }
+    if (useVectorCache)
+    {
+        control |= VectorCacheFlag;
+    }
+    co_await writeByte(ControlAddress, control);
+
+    auto t2 = m_context.now();
 
     while (true)
     {
-        co_await m_context.wait(std::chrono::microseconds(10));
+        co_await m_context.wait(m_pollInterval);
 
         ctrl = co_await readByte(ControlAddress);
         if ((ctrl & EnableFlag) == 0)
@@ -131,19 +292,117 @@ asio::awaitable<Client::Result> Client::search(std::string_view word)
         }
     }
 
+    auto t3 = m_context.now();
+
     Result result;
     result.distance = co_await readByte(DistanceAddress);
     result.index = co_await readShort(IndexAddress);
+    if (m_engineCount > 1)
+    {
+        // The index is relative to the partition of the engine which found the match
+        result.index += co_await readByte(EngineAddress) * m_partitionSize;
+    }
+
+    if (m_hasWideRegisters)
+    {
+        m_counters.cycles = co_await readLong(CyclesAddress);
+        m_counters.dictionaryStalls = co_await readLong(DictStallsAddress);
+        m_counters.vectorStalls = co_await readLong(VectorStallsAddress);
+        m_counters.dictionaryBytes = co_await readLong(DictBytesAddress);
+        m_counters.words = co_await readLong(WordsAddress);
+
+        m_counterTotals.cycles += m_counters.cycles;
+        m_counterTotals.dictionaryStalls += m_counters.dictionaryStalls;
+        m_counterTotals.vectorStalls += m_counters.vectorStalls;
+        m_counterTotals.searches++;
+    }
+
+    auto t4 = m_context.now();
 
     // Clear bitvectors
-    for (auto [c, vector] : vectorMap)
+    if (!useVectorCache)
+    {
+        for (auto [c, vector] : vectorMap)
+        {
+            co_await m_bus.write(m_vectorMapAddress + static_cast<std::uint32_t>(c) * m_bitvectorAlignment, std::as_bytes(BitVector(m_bitvectorSize).data()));
+        }
+    }
+
+    auto t5 = m_context.now();
+    m_phaseTimes.vectorUpload += (t2 - t1) + (t5 - t4);
+    m_phaseTimes.engineCycles += m_counters.cycles;
+    m_phaseTimes.resultReadout += t4 - t3;
+    m_phaseTimes.searches++;
+
+    if (m_cache)
     {
-        co_await m_bus.write(m_vectorMapAddress + static_cast<std::uint32_t>(c) * m_bitvectorAlignment, std::as_bytes(BitVector(m_bitvectorSize).data()));
+        m_cache->insert(m_dictionaryFingerprint, word, result);
     }
 
     co_return result;
 }
 
+void Client::setFrontCoding(bool enabled)
+{
+    if (enabled && m_prefixStackDepth == 0)
+    {
+        throw std::runtime_error("Device does not support front coded dictionaries");
+    }
+    m_frontCoding = enabled;
+    m_frontCodedDictionary = enabled;
+}
+
+void Client::setPollInterval(std::chrono::nanoseconds interval) noexcept
+{
+    m_pollInterval = interval;
+}
+
+void Client::setSearchGate(unsigned int search, std::function<void(bool)> gate)
+{
+    m_gatedSearch = search;
+    m_searchGate = std::move(gate);
+}
+
+void Client::setCache(QueryCache* cache) noexcept
+{
+    m_cache = cache;
+}
+
+void Client::setIndex(DeletionIndex* index)
+{
+    m_index = index;
+    clearIndex();
+}
+
+void Client::clearIndex() noexcept
+{
+    if (m_index)
+    {
+        m_index->clear();
+    }
+}
+
+void Client::indexWord(std::string_view word)
+{
+    if (m_index)
+    {
+        m_index->insert(word);
+    }
+}
+
+// Devices from before the performance counters decode only the registers up to PREFIX_DEPTH, and everything above
+// is SRAM. ENGINES is read only and never 0, while SRAM reads back what was written to it, so writing 0x00 and 0xFF
+// to it tells them apart. Without memory on the selected pin, the SRAM reads back a constant, which at worst fails
+// the probe, as one of 0x00 and 0xFF comes back as written
+asio::awaitable<bool> Client::probeWideRegisters()
+{
+    co_await writeByte(EnginesAddress, 0x00);
+    auto low = co_await readByte(EnginesAddress);
+    co_await writeByte(EnginesAddress, 0xFF);
+    auto high = co_await readByte(EnginesAddress);
+    co_return low != 0x00 && high != 0xFF && low == high;
+}
+
 asio::awaitable<void> Client::writeByte(std::uint32_t address, std::uint8_t value)
 {
     auto data = std::to_array<std::uint8_t>({value});
@@ -176,4 +435,26 @@ asio::awaitable<std::uint16_t> Client::readShort(std::uint32_t address)
         (std::to_integer<std::uint8_t>(buffer[1]));
 }
 
-} // namespace tt09_levenshtein
\ No newline at end of file
+asio::awaitable<std::uint32_t> Client::readLong(std::uint32_t address)
+{
+    std::array<std::byte, 4> buffer;
+    co_await m_bus.read(address, buffer);
+
+    co_return
+        (std::to_integer<std::uint32_t>(buffer[0]) << 24) |
+        (std::to_integer<std::uint32_t>(buffer[1]) << 16) |
+        (std::to_integer<std::uint32_t>(buffer[2]) << 8) |
+        (std::to_integer<std::uint32_t>(buffer[3]));
+}
+
+std::uint64_t Client::fingerprint(std::span<const std::byte> data, std::uint64_t hash) noexcept
+{
+    // 64-bit FNV-1a, which can be continued from a previous hash
+    for (auto value : data)
+    {
+        hash = (hash ^ std::to_integer<std::uint64_t>(value)) * 0x100000001B3;
+    }
+    return hash;
+}
+
+} // namespace tt09_levenshtein
@@ -1,28 +1,47 @@
 #pragma once
 
 #include "bus.h"
+#include "context.h"
+#include "tracer.h"
 
 #include <asio/awaitable.hpp>
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <chrono>
+#include <concepts>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <iterator>
 #include <stdexcept>
 #include <span>
+#include <string>
 #include <string_view>
+#include <vector>
 
 namespace tt09_levenshtein
 {
 
-class Context;
+class DeletionIndex;
+class QueryCache;
 
 class Client
 {
 public:
+    // Where a search result came from. Only device searches update the engine counters
+    enum class Source : std::uint8_t
+    {
+        Device,
+        Cache,
+        Index
+    };
+
     struct Result
     {
         std::uint16_t index;
         std::uint8_t distance;
+        Source source = Source::Device;
     };
     enum class ChipSelect : std::uint8_t
     {
@@ -31,6 +50,32 @@ public:
         CS2 = 2,
         CS3 = 3
     };
+    struct Counters
+    {
+        std::uint32_t cycles = 0;
+        std::uint32_t dictionaryStalls = 0;
+        std::uint32_t vectorStalls = 0;
+        std::uint32_t dictionaryBytes = 0;
+        std::uint32_t words = 0;
+    };
+    // Engine performance counters summed over all searches run on the device
+    struct CounterTotals
+    {
+        std::uint64_t cycles = 0;
+        std::uint64_t dictionaryStalls = 0;
+        std::uint64_t vectorStalls = 0;
+        std::uint64_t searches = 0;
+    };
+    struct PhaseTimes
+    {
+        std::chrono::nanoseconds init = {};
+        std::chrono::nanoseconds loadDictionary = {};
+        std::chrono::nanoseconds vectorUpload = {};
+        // Taken from the CYCLES counter, since the time spent waiting for a search also includes polling CTRL
+        std::uint64_t engineCycles = 0;
+        std::chrono::nanoseconds resultReadout = {};
+        std::uint64_t searches = 0;
+    };
     
     explicit Client(Context& context, Bus& bus) noexcept;
 
@@ -39,57 +84,184 @@ public:
         return m_maxLength;
     }
 
+    constexpr std::uint32_t vectorMapAddress() const noexcept
+    {
+        return m_vectorMapAddress;
+    }
+
+    constexpr std::uint32_t dictionaryAddress() const noexcept
+    {
+        return m_dictionaryAddress;
+    }
+
+    constexpr std::uint32_t dictionarySize() const noexcept
+    {
+        return m_dictionarySize;
+    }
+
+    constexpr std::uint32_t wordCount() const noexcept
+    {
+        return m_wordCount;
+    }
+
+    // Number of shared prefix states the engine can resume from. 0 if front coding is unsupported
+    constexpr unsigned int prefixStackDepth() const noexcept
+    {
+        return m_prefixStackDepth;
+    }
+
+    // Number of query bitvectors the engine can hold itself. 0 if the vectors must be uploaded to SRAM
+    constexpr unsigned int vectorCacheSize() const noexcept
+    {
+        return m_vectorCacheSize;
+    }
+
+    // Number of dictionary partitions the device scans in parallel
+    constexpr unsigned int engineCount() const noexcept
+    {
+        return m_engineCount;
+    }
+
+    // Whether the device has the registers above PREFIX_DEPTH: the performance counters, VECTOR_CACHE, ENGINES,
+    // ENGINE and FILL. Without them, counters() stays zero
+    constexpr bool hasWideRegisters() const noexcept
+    {
+        return m_hasWideRegisters;
+    }
+
+    // Whether the device can fill SRAM regions itself
+    constexpr bool hasFillEngine() const noexcept
+    {
+        return m_hasFillEngine;
+    }
+
+    // Fingerprint of the last dictionary loaded
+    constexpr std::uint64_t dictionaryFingerprint() const noexcept
+    {
+        return m_dictionaryFingerprint;
+    }
+
+    // Searches are answered from the cache when possible. The cache must outlive the client
+    void setCache(QueryCache* cache) noexcept;
+
+    // Searches with a close enough match are answered from the index before trying the cache or the device. The index
+    // is rebuilt whenever a dictionary is loaded, so it should be set before that. It must outlive the client
+    void setIndex(DeletionIndex* index);
+
+    // Engine performance counters of the last search
+    constexpr const Counters& counters() const noexcept
+    {
+        return m_counters;
+    }
+
+    constexpr const CounterTotals& counterTotals() const noexcept
+    {
+        return m_counterTotals;
+    }
+
+    // Time between reads of CTRL while waiting for a search to finish
+    void setPollInterval(std::chrono::nanoseconds interval) noexcept;
+
+    // Calls gate with true when the Nth search (counting from 1) starts and with false when it ends, e.g. to only trace
+    // that search. Every search counts, whether it comes from the command line, a batch or the server
+    void setSearchGate(unsigned int search, std::function<void(bool)> gate);
+
+    // Accumulated time spent in each phase, as measured by the context clock
+    constexpr const PhaseTimes& phaseTimes() const noexcept
+    {
+        return m_phaseTimes;
+    }
+
     asio::awaitable<void> init(ChipSelect memoryChipSelect, bool clearVectorMap = true);
+
+    // Sets length bytes from address to value. The device does this itself when it has a fill engine, otherwise the
+    // bytes are loaded over the bus
+    asio::awaitable<void> fill(std::uint32_t address, std::uint32_t length, std::uint8_t value);
+
+    // Front codes dictionaries loaded from now on, so the engine can skip prefixes shared with the previous word. Also
+    // marks a dictionary already on the device, e.g. from a restored snapshot, as front coded
+    void setFrontCoding(bool enabled);
     
     template<typename Container>
     asio::awaitable<void> loadDictionary(Container&& container)
     {
-        constexpr auto wordTerminator = std::to_array<std::uint8_t>({WordTerminator});
-        constexpr auto listTerminator = std::to_array<std::uint8_t>({ListTerminator});
+        AsyncTraceScope scope("client", "loadDictionary");
+        auto t1 = m_context.now();
 
-        std::uint32_t address = m_dictionaryAddress;
-        for (const auto& word : container)
+        // The whole image is built up front, so that it can be handed to the bus as a single bulk load
+        auto image = setDictionary(container);
+        co_await m_bus.load(m_dictionaryAddress, image);
+
+        m_phaseTimes.loadDictionary += m_context.now() - t1;
+    }
+
+    // Takes over a dictionary which is already on the device, e.g. from a restored snapshot, without loading it
+    template<typename Container>
+    void adoptDictionary(Container&& container)
+    {
+        setDictionary(container);
+    }
+
+    // Appends words to the loaded dictionary without reloading it
+    //
+    // The new words and the new list terminator are written first, and the old list terminator is overwritten last,
+    // so the device never sees a partially written list.
+    template<typename Container>
+    asio::awaitable<void> appendWords(Container&& container)
+    {
+        AsyncTraceScope scope("client", "appendWords");
+
+        if (m_dictionarySize == 0)
+        {
+            throw std::logic_error("Cannot append to a dictionary that has not been loaded");
+        }
+        if (m_engineCount > 1)
+        {
+            throw std::logic_error("Cannot append to a partitioned dictionary");
+        }
+        if (std::empty(container))
         {
-            co_await m_bus.write(address, std::as_bytes(std::span(word)));
-            address += word.size();
+            co_return;
+        }
+        checkWordCount(m_wordCount + std::size(container));
+
+        auto t1 = m_context.now();
+
+        auto image = buildImage(container, m_lastWord);
+        m_dictionaryHash = fingerprint(image, m_dictionaryHash);
+        image.push_back(std::byte(ListTerminator));
+
+        auto endAddress = m_dictionaryAddress + m_dictionarySize - 1;
+        co_await m_bus.load(endAddress + 1, std::span(image).subspan(1));
+        co_await m_bus.write(endAddress, std::span(image).first(1));
 
-            co_await m_bus.write(address, std::as_bytes(std::span(wordTerminator)));
-            address++;
+        m_dictionarySize += image.size() - 1;
+        m_wordCount += static_cast<std::uint32_t>(std::size(container));
+        m_dictionaryFingerprint = fingerprint(std::as_bytes(std::span(ListTerminatorBytes)), m_dictionaryHash);
+        for (const auto& word : container)
+        {
+            indexWord(word);
         }
-        
-        co_await m_bus.write(address, std::as_bytes(std::span(listTerminator)));
+        m_phaseTimes.loadDictionary += m_context.now() - t1;
     }
 
     template<typename Container>
     asio::awaitable<void> verifyDictionary(Container&& container)
     {
-        std::vector<std::uint8_t> buffer;
+        AsyncTraceScope scope("client", "verifyDictionary");
 
-        std::uint32_t address = m_dictionaryAddress;
-        for (const auto& word : container)
+        std::string previousWord;
+        auto image = buildImage(container, previousWord);
+        image.push_back(std::byte(ListTerminator));
+
+        std::vector<std::byte> buffer(image.size());
+        co_await m_bus.read(m_dictionaryAddress, buffer);
+        for (std::size_t i = 0; i != image.size(); ++i)
         {
-            buffer.resize(word.size() + 1);
-            co_await m_bus.read(address, std::as_writable_bytes(std::span(buffer)));
-            for (std::size_t i = 0; i != word.size(); ++i)
+            if (buffer[i] != image[i])
             {
-                if (buffer[i] != static_cast<std::uint8_t>(word[i]))
-                {
-                    throw std::runtime_error(fmt::format("Mismatch at address 0x{:06x}. Read {:02x}, expected {:02x}", address + i, buffer[i], static_cast<std::uint8_t>(word[i])).c_str());
-                }
+                throw std::runtime_error(fmt::format("Mismatch at address 0x{:06x}. Read {:02x}, expected {:02x}", m_dictionaryAddress + i, std::to_integer<std::uint8_t>(buffer[i]), std::to_integer<std::uint8_t>(image[i])).c_str());
             }
-            if (buffer.back() != WordTerminator)
-            {
-                throw std::runtime_error(fmt::format("Mismatch at address 0x{:06x}. Read {:02x}, expected {:02x}", address + word.size(), buffer.back(), static_cast<std::uint8_t>(WordTerminator)).c_str());
-            }
-            
-            address += word.size() + 1;
-        }
-
-        buffer.resize(1);
-        co_await m_bus.read(address, std::as_writable_bytes(std::span(buffer)));
-        if (buffer.front() != ListTerminator)
-        {
-            throw std::runtime_error(fmt::format("Mismatch at address 0x{:06x}. Read {:02x}, expected {:02x}", address, buffer.front(), static_cast<std::uint8_t>(WordTerminator)).c_str());
         }
     }
 
@@ -98,7 +270,9 @@ public:
 private:
     enum ControlFlags : std::uint8_t
     {
-        EnableFlag = 0x01
+        EnableFlag = 0x01,
+        PrefixFlag = 0x02,
+        VectorCacheFlag = 0x04
     };
 
     enum Address : std::uint32_t
@@ -108,19 +282,163 @@ private:
         LengthAddress           = 0x000002,
         MaxLengthAddress        = 0x000003,
         IndexAddress            = 0x000004,
-        DistanceAddress         = 0x000006
+        DistanceAddress         = 0x000006,
+        PrefixDepthAddress      = 0x000007,
+        CyclesAddress           = 0x000008,
+        DictStallsAddress       = 0x00000C,
+        VectorStallsAddress     = 0x000010,
+        DictBytesAddress        = 0x000014,
+        WordsAddress            = 0x000018,
+        VectorCacheAddress      = 0x00001C,
+        EnginesAddress          = 0x00001D,
+        EngineAddress           = 0x00001E,
+        FillAddress             = 0x00001F
+    };
+
+    enum FillFlags : std::uint8_t
+    {
+        FillEngineFlag = 0x01,
+        FillBusyFlag = 0x02,
+        FillRejectedFlag = 0x04
     };
 
     enum SpecialChars : std::uint8_t
     {
         WordTerminator = 0x00,
-        ListTerminator = 0x01
+        ListTerminator = 0x01,
+        PrefixHeaderOffset = 0x02
     };
 
     asio::awaitable<void> writeByte(std::uint32_t address, std::uint8_t value);
     asio::awaitable<void> writeShort(std::uint32_t address, std::uint16_t value);
     asio::awaitable<std::uint8_t> readByte(std::uint32_t address);
     asio::awaitable<std::uint16_t> readShort(std::uint32_t address);
+    asio::awaitable<std::uint32_t> readLong(std::uint32_t address);
+    asio::awaitable<bool> probeWideRegisters();
+    static constexpr std::uint64_t FingerprintSeed = 0xCBF29CE484222325;
+    static constexpr std::uint8_t ListTerminatorBytes[] = {ListTerminator};
+    // Result::index, and the INDEX register with partitions added up, are 16 bits
+    static constexpr std::size_t MaxWords = 0x10000;
+
+    static void checkWordCount(std::size_t wordCount)
+    {
+        if (wordCount > MaxWords)
+        {
+            throw std::invalid_argument(fmt::format("Dictionary of {} words exceeds {} words", wordCount, MaxWords));
+        }
+    }
+
+    // Records the dictionary as the one on the device and returns its image
+    template<typename Container>
+    std::vector<std::byte> setDictionary(Container&& container)
+    {
+        checkWordCount(std::size(container));
+
+        m_frontCodedDictionary = m_frontCoding;
+        m_lastWord.clear();
+        auto image = buildImage(container, m_lastWord);
+        m_dictionaryHash = fingerprint(image);
+        m_wordCount = static_cast<std::uint32_t>(std::size(container));
+        m_partitionSize = std::max<std::uint32_t>((m_wordCount + m_engineCount - 1) / m_engineCount, 1);
+        image.push_back(std::byte(ListTerminator));
+
+        m_dictionarySize = image.size();
+        m_dictionaryFingerprint = fingerprint(std::as_bytes(std::span(ListTerminatorBytes)), m_dictionaryHash);
+
+        clearIndex();
+        for (const auto& word : container)
+        {
+            indexWord(word);
+        }
+        return image;
+    }
+
+    // Words with their terminators, without the list terminator
+    //
+    // When front coded, each word is preceded by a header byte holding the length of the prefix it shares with the
+    // previous word plus PrefixHeaderOffset, and only the remaining suffix is stored.
+    template<typename Container>
+    std::vector<std::byte> buildImage(Container&& container, std::string& previousWord) const
+    {
+        if (m_engineCount > 1)
+        {
+            return buildPartitionedImage(container);
+        }
+
+        // A word list which already stores each word with its terminator is the image as it is
+        if constexpr (requires { { container.bytes() } -> std::convertible_to<std::span<const std::byte>>; })
+        {
+            if (!m_frontCodedDictionary)
+            {
+                auto bytes = container.bytes();
+                return std::vector<std::byte>(bytes.begin(), bytes.end());
+            }
+        }
+
+        auto maxPrefixLength = std::min(m_prefixStackDepth, 255U - PrefixHeaderOffset);
+
+        std::vector<std::byte> image;
+        for (const auto& word : container)
+        {
+            auto bytes = std::as_bytes(std::span(word));
+            if (m_frontCodedDictionary)
+            {
+                std::string_view current(word);
+                auto shared = std::mismatch(current.begin(), current.end(), previousWord.begin(), previousWord.end()).first - current.begin();
+                auto prefixLength = std::min<std::size_t>(shared, maxPrefixLength);
+                image.push_back(std::byte(prefixLength + PrefixHeaderOffset));
+                bytes = bytes.subspan(prefixLength);
+                previousWord.assign(current);
+            }
+            image.insert(image.end(), bytes.begin(), bytes.end());
+            image.push_back(std::byte(WordTerminator));
+        }
+        return image;
+    }
+
+    // The words are split into one run of consecutive words per engine, each terminated by a list terminator. The runs
+    // are interleaved byte by byte and the shorter ones padded with list terminators, which the engines skip. Since
+    // every byte of the final group is a list terminator, the last one is left out like for a regular image.
+    template<typename Container>
+    std::vector<std::byte> buildPartitionedImage(Container&& container) const
+    {
+        auto wordCount = static_cast<std::size_t>(std::size(container));
+        auto partitionSize = std::max<std::size_t>((wordCount + m_engineCount - 1) / m_engineCount, 1);
+
+        std::vector<std::vector<std::byte>> partitions(m_engineCount);
+        std::size_t index = 0;
+        for (const auto& word : container)
+        {
+            auto& partition = partitions[index++ / partitionSize];
+            auto bytes = std::as_bytes(std::span(word));
+            partition.insert(partition.end(), bytes.begin(), bytes.end());
+            partition.push_back(std::byte(WordTerminator));
+        }
+
+        std::size_t length = 0;
+        for (const auto& partition : partitions)
+        {
+            length = std::max(length, partition.size() + 1);
+        }
+
+        std::vector<std::byte> image(length * m_engineCount, std::byte(ListTerminator));
+        for (std::size_t engine = 0; engine != m_engineCount; ++engine)
+        {
+            for (std::size_t i = 0; i != partitions[engine].size(); ++i)
+            {
+                image[i * m_engineCount + engine] = partitions[engine][i];
+            }
+        }
+        image.pop_back();
+        return image;
+    }
+
+    static std::uint64_t fingerprint(std::span<const std::byte> data, std::uint64_t hash = FingerprintSeed) noexcept;
+
+    // Keep the index in step with the dictionary. The index is only forward declared here, so the templates go through
+    // these
+    void clearIndex() noexcept;
+    void indexWord(std::string_view word);
 
     Context& m_context;
     Bus& m_bus;
@@ -129,6 +447,28 @@ private:
     unsigned int m_bitvectorAlignment = 0;
     std::uint32_t m_vectorMapAddress = 0;
     std::uint32_t m_dictionaryAddress = 0;
+    std::uint32_t m_dictionarySize = 0;
+    std::uint32_t m_wordCount = 0;
+    unsigned int m_prefixStackDepth = 0;
+    unsigned int m_vectorCacheSize = 0;
+    unsigned int m_engineCount = 1;
+    std::uint32_t m_partitionSize = 0;
+    bool m_hasWideRegisters = false;
+    bool m_hasFillEngine = false;
+    bool m_frontCoding = false;
+    bool m_frontCodedDictionary = false;
+    std::string m_lastWord;
+    std::uint64_t m_dictionaryHash = FingerprintSeed;
+    std::uint64_t m_dictionaryFingerprint = 0;
+    QueryCache* m_cache = nullptr;
+    DeletionIndex* m_index = nullptr;
+    unsigned int m_searchCount = 0;
+    unsigned int m_gatedSearch = 0;
+    std::function<void(bool)> m_searchGate;
+    Counters m_counters;
+    CounterTotals m_counterTotals;
+    std::chrono::nanoseconds m_pollInterval = std::chrono::microseconds(10);
+    PhaseTimes m_phaseTimes;
 };
 
 } // namespace tt09_levenshtein
\ No newline at end of file
@@ -14,6 +14,7 @@ public:
 
     virtual asio::awaitable<void> init() = 0;
     virtual asio::awaitable<void> wait(std::chrono::nanoseconds time) = 0;
+    virtual std::chrono::nanoseconds now() const noexcept = 0;
 };
 
 } // namespace tt09_levenshtein
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include "deletion_index.h"
+
+#include "levenshtein.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace tt09_levenshtein
+{
+
+DeletionIndex::DeletionIndex(unsigned int maxDistance)
+    : m_maxDistance(maxDistance)
+{
+    if (maxDistance > MaxDistance)
+    {
+        throw std::invalid_argument(fmt::format("Index distance {} exceeds {}", maxDistance, MaxDistance));
+    }
+}
+
+void DeletionIndex::clear() noexcept
+{
+    m_words.clear();
+    m_entries.clear();
+    m_entryCount = 0;
+}
+
+void DeletionIndex::insert(std::string_view word)
+{
+    // The table is kept at most half full, so that probes stay short
+    auto wordDeletions = deletions(word);
+    if ((m_entryCount + wordDeletions.size()) * 2 > m_entries.size())
+    {
+        grow(m_entryCount + wordDeletions.size());
+    }
+
+    auto index = static_cast<std::uint32_t>(m_words.size());
+    m_words.push_back(word);
+    for (const auto& deletion : wordDeletions)
+    {
+        addEntry(hash(deletion), index);
+    }
+    m_entryCount += wordDeletions.size();
+}
+
+std::optional<Client::Result> DeletionIndex::find(std::string_view query)
+{
+    m_candidates.clear();
+    if (!m_entries.empty())
+    {
+        auto mask = m_entries.size() - 1;
+        for (const auto& deletion : deletions(query))
+        {
+            auto h = hash(deletion);
+            auto tag = static_cast<std::uint32_t>(h >> 32);
+            for (auto slot = h & mask; m_entries[slot].index != EmptyIndex; slot = (slot + 1) & mask)
+            {
+                if (m_entries[slot].tag == tag)
+                {
+                    m_candidates.push_back(m_entries[slot].index);
+                }
+            }
+        }
+    }
+
+    // Going through the candidates in index order, only a strictly closer word replaces the best one, so ties go to
+    // the lowest index like on the device
+    std::sort(m_candidates.begin(), m_candidates.end());
+    m_candidates.erase(std::unique(m_candidates.begin(), m_candidates.end()), m_candidates.end());
+
+    std::optional<Client::Result> result;
+    for (auto index : m_candidates)
+    {
+        auto word = m_words[index];
+        auto lengthDifference = word.size() > query.size() ? word.size() - query.size() : query.size() - word.size();
+        if (lengthDifference > m_maxDistance)
+        {
+            continue;
+        }
+
+        auto distance = levenshtein(query, word);
+        if (distance <= m_maxDistance && (!result || distance < result->distance))
+        {
+            result = Client::Result{static_cast<std::uint16_t>(index), static_cast<std::uint8_t>(distance), Client::Source::Index};
+            if (distance == 0)
+            {
+                break;
+            }
+        }
+    }
+
+    if (result)
+    {
+        m_statistics.hits++;
+    }
+    else
+    {
+        m_statistics.misses++;
+    }
+    return result;
+}
+
+// Each distinct string with up to m_maxDistance characters deleted, including the word itself
+std::vector<std::string> DeletionIndex::deletions(std::string_view word) const
+{
+    std::vector<std::string> result{std::string(word)};
+    std::size_t levelStart = 0;
+    for (unsigned int level = 0; level != m_maxDistance; ++level)
+    {
+        auto levelEnd = result.size();
+        for (auto i = levelStart; i != levelEnd; ++i)
+        {
+            for (std::size_t position = 0; position != result[i].size(); ++position)
+            {
+                auto deletion = result[i];
+                deletion.erase(position, 1);
+                result.push_back(std::move(deletion));
+            }
+        }
+
+        // Deleting different characters can give the same string, e.g. either character of a repeated pair
+        std::sort(result.begin() + levelEnd, result.end());
+        result.erase(std::unique(result.begin() + levelEnd, result.end()), result.end());
+        levelStart = levelEnd;
+    }
+    return result;
+}
+
+std::uint64_t DeletionIndex::hash(std::string_view string) noexcept
+{
+    // Spread the bits, so that both the slot and the tag are usable whatever the standard library hash looks like
+    auto h = static_cast<std::uint64_t>(std::hash<std::string_view>{}(string));
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCD;
+    h ^= h >> 33;
+    return h;
+}
+
+void DeletionIndex::addEntry(std::uint64_t hash, std::uint32_t index) noexcept
+{
+    auto mask = m_entries.size() - 1;
+    auto slot = hash & mask;
+    while (m_entries[slot].index != EmptyIndex)
+    {
+        slot = (slot + 1) & mask;
+    }
+    m_entries[slot] = Entry{static_cast<std::uint32_t>(hash >> 32), index};
+}
+
+void DeletionIndex::grow(std::size_t entryCount)
+{
+    auto capacity = std::max(m_entries.size(), MinCapacity);
+    while (entryCount * 2 > capacity)
+    {
+        capacity *= 2;
+    }
+
+    // The slot of an entry can't be recovered from its tag, so the table is rebuilt from the words
+    m_entries.assign(capacity, Entry{0, EmptyIndex});
+    for (std::size_t index = 0; index != m_words.size(); ++index)
+    {
+        for (const auto& deletion : deletions(m_words[index]))
+        {
+            addEntry(hash(deletion), static_cast<std::uint32_t>(index));
+        }
+    }
+}
+
+} // namespace tt09_levenshtein
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "client.h"
+#include "word_list.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tt09_levenshtein
+{
+
+// Host index of the dictionary which answers searches whose best match is within a small distance
+//
+// Every word is entered under each string obtained by deleting up to the maximum distance characters from it. Two words
+// within that distance of each other always share such a string, so looking up the deletions of a query finds every
+// word close enough to it. The candidates are then compared to the query, and the closest one with the lowest index
+// is the result, like on the device. When no word is within the maximum distance, the search has to go to the device.
+class DeletionIndex
+{
+public:
+    struct Statistics
+    {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+    };
+
+    // The number of entries grows quickly with the distance, so it is limited
+    static constexpr unsigned int MaxDistance = 2;
+
+    explicit DeletionIndex(unsigned int maxDistance);
+
+    void clear() noexcept;
+    // Adds a word with the next index
+    void insert(std::string_view word);
+    std::optional<Client::Result> find(std::string_view query);
+
+    constexpr unsigned int maxDistance() const noexcept
+    {
+        return m_maxDistance;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_words.size();
+    }
+
+    constexpr std::size_t entryCount() const noexcept
+    {
+        return m_entryCount;
+    }
+
+    constexpr const Statistics& statistics() const noexcept
+    {
+        return m_statistics;
+    }
+
+private:
+    // Open addressing with linear probing. Entries of the same deletion are simply stored in consecutive slots. The tag
+    // is the part of the hash not used for the slot, and tells most other deletions apart without comparing strings
+    struct Entry
+    {
+        std::uint32_t tag;
+        std::uint32_t index;
+    };
+
+    static constexpr std::uint32_t EmptyIndex = 0xFFFFFFFF;
+    static constexpr std::size_t MinCapacity = 1024;
+
+    std::vector<std::string> deletions(std::string_view word) const;
+    static std::uint64_t hash(std::string_view string) noexcept;
+    void addEntry(std::uint64_t hash, std::uint32_t index) noexcept;
+    void grow(std::size_t entryCount);
+
+    unsigned int m_maxDistance;
+    WordList m_words;
+    std::vector<Entry> m_entries;
+    std::size_t m_entryCount = 0;
+    std::vector<std::uint32_t> m_candidates;
+    Statistics m_statistics;
+};
+
+} // namespace tt09_levenshtein
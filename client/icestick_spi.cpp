@@ -1,5 +1,7 @@
 #include "icestick_spi.h"
 
+#include "tracer.h"
+
 #include <asio/post.hpp>
 #include <asio/this_coro.hpp>
 #include <asio/use_awaitable.hpp>
@@ -79,6 +81,8 @@ asio::awaitable<void> IcestickSpi::setSS(bool high)
 
 asio::awaitable<void> IcestickSpi::xmit(std::span<const std::byte> data, std::span<std::byte> buffer)
 {
+    AsyncTraceScope scope("spi", "xmit");
+
     std::vector<std::uint8_t> commands;
     commands.reserve(7 + data.size() + buffer.size());
 
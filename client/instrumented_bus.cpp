@@ -0,0 +1,112 @@
+#include "instrumented_bus.h"
+
+#include "spi_bus.h"
+
+#include <bit>
+#include <chrono>
+
+namespace tt09_levenshtein
+{
+
+InstrumentedBus::InstrumentedBus(Bus& bus, const SpiBus* spiBus) noexcept
+    : m_bus(bus)
+    , m_spiBus(spiBus)
+{
+    reset();
+}
+
+asio::awaitable<void> InstrumentedBus::read(std::uint32_t address, std::span<std::byte> buffer)
+{
+    auto t1 = std::chrono::steady_clock::now();
+    co_await m_bus.read(address, buffer);
+    auto t2 = std::chrono::steady_clock::now();
+
+    auto& stats = m_statistics.regions[static_cast<std::size_t>(region(address))];
+    stats.reads++;
+    stats.bytesRead += buffer.size();
+    m_statistics.readLatency[latencyBucket(std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count())]++;
+}
+
+asio::awaitable<void> InstrumentedBus::write(std::uint32_t address, std::span<const std::byte> data)
+{
+    auto t1 = std::chrono::steady_clock::now();
+    co_await m_bus.write(address, data);
+    auto t2 = std::chrono::steady_clock::now();
+
+    auto& stats = m_statistics.regions[static_cast<std::size_t>(region(address))];
+    stats.writes++;
+    stats.bytesWritten += data.size();
+    m_statistics.writeLatency[latencyBucket(std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count())]++;
+}
+
+asio::awaitable<void> InstrumentedBus::load(std::uint32_t address, std::span<const std::byte> data)
+{
+    auto t1 = std::chrono::steady_clock::now();
+    co_await m_bus.load(address, data);
+    auto t2 = std::chrono::steady_clock::now();
+
+    auto& stats = m_statistics.regions[static_cast<std::size_t>(region(address))];
+    stats.writes++;
+    stats.bytesWritten += data.size();
+    m_statistics.writeLatency[latencyBucket(std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count())]++;
+}
+
+void InstrumentedBus::setLayout(std::uint32_t vectorMapAddress, std::uint32_t dictionaryAddress) noexcept
+{
+    m_vectorMapAddress = vectorMapAddress;
+    m_dictionaryAddress = dictionaryAddress;
+}
+
+InstrumentedBus::Statistics InstrumentedBus::snapshot() const noexcept
+{
+    auto statistics = m_statistics;
+    if (m_spiBus)
+    {
+        statistics.syncRetries = m_spiBus->syncRetries() - m_syncRetriesBase;
+    }
+    return statistics;
+}
+
+void InstrumentedBus::reset() noexcept
+{
+    m_statistics = {};
+    m_syncRetriesBase = m_spiBus ? m_spiBus->syncRetries() : 0;
+}
+
+const char* InstrumentedBus::regionName(Region region) noexcept
+{
+    switch (region)
+    {
+        case Region::Registers:
+            return "Registers";
+        case Region::VectorMap:
+            return "VECTORMAP";
+        case Region::Dictionary:
+            return "DICT";
+    }
+    return "Unknown";
+}
+
+InstrumentedBus::Region InstrumentedBus::region(std::uint32_t address) const noexcept
+{
+    if (address < m_vectorMapAddress)
+    {
+        return Region::Registers;
+    }
+    else if (address < m_dictionaryAddress)
+    {
+        return Region::VectorMap;
+    }
+    else
+    {
+        return Region::Dictionary;
+    }
+}
+
+std::size_t InstrumentedBus::latencyBucket(std::uint64_t nanoseconds) noexcept
+{
+    auto bucket = static_cast<std::size_t>(std::bit_width(nanoseconds / 1000));
+    return bucket < LatencyBucketCount ? bucket : LatencyBucketCount - 1;
+}
+
+} // namespace tt09_levenshtein
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "bus.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace tt09_levenshtein
+{
+
+class SpiBus;
+
+class InstrumentedBus : public Bus
+{
+public:
+    enum class Region : std::size_t
+    {
+        Registers,
+        VectorMap,
+        Dictionary
+    };
+    static constexpr std::size_t RegionCount = 3;
+
+    // Bucket n counts transactions taking [2^(n-1), 2^n) microseconds. Bucket 0 counts anything below 1 µs
+    static constexpr std::size_t LatencyBucketCount = 24;
+
+    struct RegionStatistics
+    {
+        std::uint64_t reads = 0;
+        std::uint64_t writes = 0;
+        std::uint64_t bytesRead = 0;
+        std::uint64_t bytesWritten = 0;
+    };
+
+    struct Statistics
+    {
+        std::array<RegionStatistics, RegionCount> regions = {};
+        std::array<std::uint64_t, LatencyBucketCount> readLatency = {};
+        std::array<std::uint64_t, LatencyBucketCount> writeLatency = {};
+        std::uint64_t syncRetries = 0;
+    };
+
+    explicit InstrumentedBus(Bus& bus, const SpiBus* spiBus = nullptr) noexcept;
+
+    asio::awaitable<void> read(std::uint32_t address, std::span<std::byte> buffer) override;
+    asio::awaitable<void> write(std::uint32_t address, std::span<const std::byte> data) override;
+    asio::awaitable<void> load(std::uint32_t address, std::span<const std::byte> data) override;
+
+    void setLayout(std::uint32_t vectorMapAddress, std::uint32_t dictionaryAddress) noexcept;
+
+    Statistics snapshot() const noexcept;
+    void reset() noexcept;
+
+    static const char* regionName(Region region) noexcept;
+
+private:
+    Region region(std::uint32_t address) const noexcept;
+    static std::size_t latencyBucket(std::uint64_t nanoseconds) noexcept;
+
+    Bus& m_bus;
+    const SpiBus* m_spiBus;
+    std::uint32_t m_vectorMapAddress = 0x000200;
+    std::uint32_t m_dictionaryAddress = 0x000400;
+    std::uint64_t m_syncRetriesBase = 0;
+    Statistics m_statistics;
+};
+
+} // namespace tt09_levenshtein
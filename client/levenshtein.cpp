@@ -6,7 +6,11 @@
 namespace tt09_levenshtein
 {
 
-unsigned int levenshtein(std::u32string_view s, std::u32string_view t) noexcept
+namespace
+{
+
+template<typename Char>
+unsigned int distance(std::basic_string_view<Char> s, std::basic_string_view<Char> t) noexcept
 {
 	auto m = s.size();
 	auto n = t.size();
@@ -30,4 +34,16 @@ unsigned int levenshtein(std::u32string_view s, std::u32string_view t) noexcept
 	return d[n][m];
 }
 
-} // namespace tt09_levenshtein
\ No newline at end of file
+} // namespace
+
+unsigned int levenshtein(std::u32string_view s, std::u32string_view t) noexcept
+{
+	return distance(s, t);
+}
+
+unsigned int levenshtein(std::string_view s, std::string_view t) noexcept
+{
+	return distance(s, t);
+}
+
+} // namespace tt09_levenshtein
@@ -6,5 +6,7 @@ namespace tt09_levenshtein
 {
 
 unsigned int levenshtein(std::u32string_view s, std::u32string_view t) noexcept;
+// Distance between strings of mapped characters, which are one byte each
+unsigned int levenshtein(std::string_view s, std::string_view t) noexcept;
 
 } // namespace tt09_levenshtein
\ No newline at end of file
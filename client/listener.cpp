@@ -0,0 +1,71 @@
+#include "listener.h"
+
+#include <asio/signal_set.hpp>
+#include <fmt/format.h>
+#include <fmt/printf.h>
+
+#include <csignal>
+#include <stdexcept>
+
+namespace tt09_levenshtein
+{
+
+namespace
+{
+
+// Removes a socket left behind by an earlier server, but never anything else found at the path
+void removeStaleSocket(const std::filesystem::path& path)
+{
+    auto status = std::filesystem::symlink_status(path);
+    if (std::filesystem::is_socket(status))
+    {
+        std::filesystem::remove(path);
+    }
+    else if (std::filesystem::exists(status))
+    {
+        throw std::runtime_error(fmt::format("{} exists and is not a socket", path.string()));
+    }
+}
+
+} // namespace
+
+Listener::Listener(const Config& config, std::string name)
+    : m_config(config)
+    , m_name(std::move(name))
+{
+}
+
+void Listener::open(const asio::any_io_executor& executor)
+{
+    if (m_config.socketPath)
+    {
+        removeStaleSocket(*m_config.socketPath);
+        m_localAcceptor.emplace(executor, asio::local::stream_protocol::endpoint(m_config.socketPath->string()));
+        fmt::println("Listening on {} ({} server)", m_config.socketPath->string(), m_name);
+    }
+    if (m_config.port)
+    {
+        m_tcpAcceptor.emplace(executor, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), *m_config.port));
+        fmt::println("Listening on port {} ({} server)", *m_config.port, m_name);
+    }
+}
+
+asio::awaitable<void> Listener::waitForShutdown()
+{
+    asio::signal_set signals(co_await asio::this_coro::executor, SIGINT, SIGTERM);
+    co_await signals.async_wait(asio::use_awaitable);
+
+    fmt::println("Shutting down {} server", m_name);
+
+    if (m_localAcceptor)
+    {
+        m_localAcceptor->close();
+        std::filesystem::remove(*m_config.socketPath);
+    }
+    if (m_tcpAcceptor)
+    {
+        m_tcpAcceptor->close();
+    }
+}
+
+} // namespace tt09_levenshtein
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <asio/any_io_executor.hpp>
+#include <asio/awaitable.hpp>
+#include <asio/co_spawn.hpp>
+#include <asio/detached.hpp>
+#include <asio/ip/tcp.hpp>
+#include <asio/local/stream_protocol.hpp>
+#include <asio/this_coro.hpp>
+#include <asio/use_awaitable.hpp>
+
+#include <exception>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace tt09_levenshtein
+{
+
+// Accepts connections on a Unix domain socket and/or a TCP port on the loopback address and serves each of them in
+// its own coroutine, until SIGINT or SIGTERM is received
+class Listener
+{
+public:
+    struct Config
+    {
+        std::optional<std::filesystem::path> socketPath;
+        std::optional<unsigned short> port;
+    };
+
+    // The name is only used in messages, e.g. "device" for "Shutting down device server"
+    Listener(const Config& config, std::string name);
+
+    // The handler is called with each accepted socket, which is either a local or a TCP socket, and returns the
+    // awaitable serving it
+    template<typename Handler>
+    asio::awaitable<void> run(Handler handler);
+
+private:
+    void open(const asio::any_io_executor& executor);
+    asio::awaitable<void> waitForShutdown();
+
+    template<typename Acceptor, typename Handler>
+    static asio::awaitable<void> accept(Acceptor& acceptor, Handler handler);
+
+    Config m_config;
+    std::string m_name;
+    std::optional<asio::local::stream_protocol::acceptor> m_localAcceptor;
+    std::optional<asio::ip::tcp::acceptor> m_tcpAcceptor;
+};
+
+template<typename Handler>
+asio::awaitable<void> Listener::run(Handler handler)
+{
+    auto executor = co_await asio::this_coro::executor;
+
+    open(executor);
+    if (m_localAcceptor)
+    {
+        asio::co_spawn(executor, accept(*m_localAcceptor, handler), asio::detached);
+    }
+    if (m_tcpAcceptor)
+    {
+        asio::co_spawn(executor, accept(*m_tcpAcceptor, handler), asio::detached);
+    }
+
+    co_await waitForShutdown();
+}
+
+template<typename Acceptor, typename Handler>
+asio::awaitable<void> Listener::accept(Acceptor& acceptor, Handler handler)
+{
+    auto executor = co_await asio::this_coro::executor;
+
+    try
+    {
+        while (true)
+        {
+            auto socket = co_await acceptor.async_accept(asio::use_awaitable);
+            asio::co_spawn(executor, handler(std::move(socket)), asio::detached);
+        }
+    }
+    catch (const std::exception&)
+    {
+        // Acceptor closed
+    }
+}
+
+} // namespace tt09_levenshtein
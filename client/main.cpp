@@ -15,16 +15,28 @@ int main(int argc, char** argv)
     bool showHelp = false;
     std::string interfaceName = "verilog";
     std::string chipSelectName = "cs";
-    std::optional<std::filesystem::path> vcdPath;
+    std::string batchFormat = "tsv";
     tt09_levenshtein::Runner::Config config;
 
     auto cli = lyra::cli()
-        | lyra::opt(interfaceName, "DEVICE")["-i"]["--interface"]("Interface (verilator, icestick)").choices("verilator", "icestick")
+        | lyra::opt(interfaceName, "DEVICE")["-i"]["--interface"]("Interface (verilator, icestick, remote)").choices("verilator", "icestick", "remote")
         | lyra::opt(chipSelectName, "PIN")["-c"]["--chip-select"]("Memory chip select pin (cs, cs2, cs3)").choices("cs", "cs2", "cs3")
-        | lyra::opt(vcdPath, "FILE")["-v"]["--vcd-file"]("Create VCD file")
+        | lyra::opt(config.tracePath, "FILE")["-f"]["--fst-file"]("Create FST waveform file")
+        | lyra::opt(config.traceScope, "SCOPE")["--trace-scope"]("Only trace below hierarchy prefix (e.g. TOP.top.levenshtein)")
+        | lyra::opt(config.traceDepth, "NUM")["--trace-depth"]("Trace hierarchy depth")
+        | lyra::opt(config.traceStartTime, "NS")["--trace-start-time"]("Start tracing at simulated time")
+        | lyra::opt(config.traceStopTime, "NS")["--trace-stop-time"]("Stop tracing at simulated time")
+        | lyra::opt(config.traceStartCycle, "NUM")["--trace-start-cycle"]("Start tracing at clock cycle")
+        | lyra::opt(config.traceStopCycle, "NUM")["--trace-stop-cycle"]("Stop tracing at clock cycle")
+        | lyra::opt(config.traceSearch, "NUM")["--trace-search"]("Only trace the Nth search (counting from 1)")
         | lyra::opt(config.dictionaryPath, "FILE")["-d"]["--dictionary"]("Dictionary")
+        | lyra::opt(config.frontCoding)["--front-coding"]("Front code the dictionary so the engine can skip shared prefixes")
+        | lyra::opt(config.appendPath, "FILE")["--append"]("Append words to the loaded dictionary")
         | lyra::opt(config.noClear)["--no-clear"]("Skip clearing vector map on initialization")
         | lyra::opt(config.noLoadDictionary)["--no-load-dictionary"]("Skip loading dictionary")
+        | lyra::opt(config.backdoor)["--backdoor"]("Load memory directly into the simulated SRAM (verilator only)")
+        | lyra::opt(config.saveStatePath, "FILE")["--save-state"]("Save simulation state after loading the dictionary (verilator only)")
+        | lyra::opt(config.restoreStatePath, "FILE")["--restore-state"]("Restore simulation state instead of loading the dictionary (verilator only)")
         | lyra::opt(config.verifyDictionary)["--verify-dictionary"]("Verify dictionary")
         | lyra::opt(config.searchWord, "WORD")["-s"]["--search"]("Search for word")
         | lyra::opt(config.verifySearch)["--verify-search"]("Verify search")
@@ -32,6 +44,30 @@ int main(int argc, char** argv)
         | lyra::opt(config.testAlphabetSize, "NUM")["--test-alphabet-size"]("Test alphabet size")
         | lyra::opt(config.testDictionarySize, "NUM")["--test-dictionary-size"]("Test dictionary size")
         | lyra::opt(config.testSearchCount, "NUM")["--test-search-count"]("Test search count")
+        | lyra::opt(config.testSeed, "NUM")["--test-seed"]("Test random seed")
+        | lyra::opt(config.testCharSkew, "S")["--test-char-skew"]("Zipf exponent of test characters (0 for uniform)")
+        | lyra::opt(config.testCorpusPath, "FILE")["--test-corpus"]("Draw test characters and word lengths from word list")
+        | lyra::opt(config.testSearchEdits, "NUM")["--test-search-edits"]("Derive test search words from dictionary words with this many edits")
+        | lyra::opt(config.batchPath, "FILE")["--batch"]("Search for each line of file (- for stdin)")
+        | lyra::opt(config.batchOutputPath, "FILE")["--batch-output"]("Write batch results to file instead of stdout")
+        | lyra::opt(batchFormat, "FORMAT")["--batch-format"]("Batch result format (tsv, json)").choices("tsv", "json")
+        | lyra::opt(config.listenSocketPath, "PATH")["--listen-socket"]("Serve searches on Unix domain socket")
+        | lyra::opt(config.listenPort, "PORT")["--listen-port"]("Serve searches on TCP port on the loopback address")
+        | lyra::opt(config.remoteSocketPath, "PATH")["--remote-socket"]("Connect to remote device on Unix domain socket (remote only)")
+        | lyra::opt(config.remoteHost, "HOST")["--remote-host"]("Connect to remote device on host (remote only)")
+        | lyra::opt(config.remotePort, "PORT")["--remote-port"]("Connect to remote device on TCP port (remote only)")
+        | lyra::opt(config.serveDeviceSocketPath, "PATH")["--serve-device-socket"]("Serve the device bus to remote clients on Unix domain socket")
+        | lyra::opt(config.serveDevicePort, "PORT")["--serve-device-port"]("Serve the device bus to remote clients on TCP port on the loopback address")
+        | lyra::opt(config.shortestFirst)["--shortest-first"]("Serve queued searches for shorter words first")
+        | lyra::opt(config.cacheSize, "BYTES")["--cache-size"]("Cache search results in up to this many bytes")
+        | lyra::opt(config.indexDistance, "NUM")["--index-distance"]("Answer searches with a match within this distance (up to 2) from a host index")
+        | lyra::opt(config.showStatistics)["--stats"]("Show bus statistics")
+        | lyra::opt(config.timelinePath, "FILE")["--timeline"]("Write Chrome trace-event timeline")
+        | lyra::opt(config.showCounters)["--counters"]("Show engine performance counters for each search")
+        | lyra::opt(config.pollInterval, "NS")["--poll-interval"]("Time between status polls while a search runs")
+        | lyra::opt(config.showProjection)["--projection"]("Project simulated phase times onto real silicon")
+        | lyra::opt(config.projectionCoreClock, "HZ")["--projection-core-clock"]("Core clock used for projection")
+        | lyra::opt(config.projectionSpiClock, "HZ")["--projection-spi-clock"]("SPI clock used for projection")
         | lyra::help(showHelp);
 
     auto result = cli.parse({argc, argv});
@@ -46,11 +82,17 @@ int main(int argc, char** argv)
         return EXIT_SUCCESS;
     }
 
+    config.batchJson = batchFormat == "json";
+
     tt09_levenshtein::Runner::Device device;
     if (interfaceName == "icestick")
     {
         device = tt09_levenshtein::Runner::Device::Icestick;
     }
+    else if (interfaceName == "remote")
+    {
+        device = tt09_levenshtein::Runner::Device::Remote;
+    }
     else
     {
         device = tt09_levenshtein::Runner::Device::Verilator;
@@ -71,10 +113,6 @@ int main(int argc, char** argv)
     }
 
     tt09_levenshtein::Runner runner(device, chipSelect);
-    if (vcdPath)
-    {
-        runner.setVcdPath(*vcdPath);
-    }
 
     try
     {
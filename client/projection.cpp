@@ -0,0 +1,71 @@
+#include "projection.h"
+
+#include <fmt/printf.h>
+
+namespace tt09_levenshtein
+{
+
+namespace
+{
+
+double toMilliseconds(std::chrono::nanoseconds time) noexcept
+{
+    return std::chrono::duration<double, std::milli>(time).count();
+}
+
+} // namespace
+
+Projection::Projection(const Config& config) noexcept
+    : m_config(config)
+{
+}
+
+void Projection::print(std::FILE* file, const Client::PhaseTimes& phaseTimes, std::uint32_t dictionarySize) const
+{
+    fmt::println(file, "Projection at \033[36m{:.1f}\033[0m MHz core clock and \033[36m{:.1f}\033[0m MHz SPI clock:", m_config.coreClock / 1e6, m_config.spiClock / 1e6);
+    fmt::println(file, "  {:<16} {:>14} {:>14}", "Phase", "Sim. cycles", "Projected ms");
+
+    auto printPhase = [file](const char* name, std::uint64_t simulatedCycles, std::chrono::nanoseconds projectedTime)
+    {
+        fmt::println(file, "  {:<16} {:>14} {:>14.3f}", name, simulatedCycles, toMilliseconds(projectedTime));
+    };
+
+    printPhase("Init", cycles(phaseTimes.init), projectLink(phaseTimes.init));
+    printPhase("Load dictionary", cycles(phaseTimes.loadDictionary), projectLink(phaseTimes.loadDictionary));
+    printPhase("Vector upload", cycles(phaseTimes.vectorUpload), projectLink(phaseTimes.vectorUpload));
+    printPhase("Engine scan", phaseTimes.engineCycles, projectEngine(phaseTimes.engineCycles));
+    printPhase("Result readout", cycles(phaseTimes.resultReadout), projectLink(phaseTimes.resultReadout));
+
+    if (phaseTimes.searches == 0)
+    {
+        return;
+    }
+
+    auto searches = static_cast<double>(phaseTimes.searches);
+    auto searchTime = projectLink(phaseTimes.vectorUpload) + projectEngine(phaseTimes.engineCycles) + projectLink(phaseTimes.resultReadout);
+    auto latency = toMilliseconds(searchTime) / searches;
+
+    fmt::println(file, "  Search latency: \033[36m{:.3f}\033[0m ms ({:.0f} searches/s)", latency, 1000.0 / latency);
+    if (dictionarySize != 0)
+    {
+        fmt::println(file, "  Engine cycles per dictionary byte: \033[36m{:.2f}\033[0m", phaseTimes.engineCycles / searches / dictionarySize);
+    }
+}
+
+std::uint64_t Projection::cycles(std::chrono::nanoseconds simulatedTime) const noexcept
+{
+    return static_cast<std::uint64_t>(simulatedTime.count() * (m_config.simulatedCoreClock / 1e9));
+}
+
+std::chrono::nanoseconds Projection::projectEngine(std::uint64_t engineCycles) const noexcept
+{
+    return std::chrono::nanoseconds(static_cast<std::int64_t>(engineCycles * (1e9 / m_config.coreClock)));
+}
+
+std::chrono::nanoseconds Projection::projectLink(std::chrono::nanoseconds simulatedTime) const noexcept
+{
+    auto spiCycles = static_cast<double>(cycles(simulatedTime)) / m_config.simulatedSpiDivider;
+    return std::chrono::nanoseconds(static_cast<std::int64_t>(spiCycles * (1e9 / m_config.spiClock)));
+}
+
+} // namespace tt09_levenshtein
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "client.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace tt09_levenshtein
+{
+
+// Projects simulated phase times onto a real device running at a given core and SPI clock
+//
+// The engine scan is bound by the core clock, so the cycles counted by the engine are scaled directly. Host link phases
+// are bound by the SPI clock, so their simulated time is converted to SPI clock periods using the simulated SPI divider
+// first.
+class Projection
+{
+public:
+    struct Config
+    {
+        unsigned long int simulatedCoreClock = 50000000;
+        unsigned int simulatedSpiDivider = 4;
+        unsigned long int coreClock = 50000000;
+        unsigned long int spiClock = 12500000;
+    };
+
+    explicit Projection(const Config& config) noexcept;
+
+    void print(std::FILE* file, const Client::PhaseTimes& phaseTimes, std::uint32_t dictionarySize) const;
+
+private:
+    std::uint64_t cycles(std::chrono::nanoseconds simulatedTime) const noexcept;
+    std::chrono::nanoseconds projectEngine(std::uint64_t engineCycles) const noexcept;
+    std::chrono::nanoseconds projectLink(std::chrono::nanoseconds simulatedTime) const noexcept;
+
+    Config m_config;
+};
+
+} // namespace tt09_levenshtein
@@ -0,0 +1,81 @@
+#include "query_cache.h"
+
+namespace tt09_levenshtein
+{
+
+QueryCache::QueryCache(std::size_t capacity) noexcept
+    : m_capacity(capacity)
+{
+}
+
+std::optional<Client::Result> QueryCache::find(std::uint64_t fingerprint, std::string_view query)
+{
+    auto it = m_index.find(makeKey(fingerprint, query));
+    if (it == m_index.end())
+    {
+        m_statistics.misses++;
+        return std::nullopt;
+    }
+
+    m_statistics.hits++;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return it->second->result;
+}
+
+void QueryCache::insert(std::uint64_t fingerprint, std::string_view query, const Client::Result& result)
+{
+    auto key = makeKey(fingerprint, query);
+    auto size = entrySize(key);
+    if (size > m_capacity)
+    {
+        return;
+    }
+
+    auto it = m_index.find(key);
+    if (it != m_index.end())
+    {
+        it->second->result = result;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return;
+    }
+
+    while (m_size + size > m_capacity)
+    {
+        const auto& last = m_entries.back();
+        m_size -= entrySize(last.key);
+        m_index.erase(last.key);
+        m_entries.pop_back();
+        m_statistics.evictions++;
+    }
+
+    // The index refers to the key stored in the list node, which never moves
+    m_entries.push_front(Entry{std::move(key), result});
+    m_index.emplace(m_entries.front().key, m_entries.begin());
+    m_size += size;
+}
+
+void QueryCache::clear() noexcept
+{
+    m_index.clear();
+    m_entries.clear();
+    m_size = 0;
+}
+
+std::string QueryCache::makeKey(std::uint64_t fingerprint, std::string_view query)
+{
+    std::string key;
+    key.reserve(sizeof(fingerprint) + query.size());
+    for (unsigned int i = 0; i != sizeof(fingerprint); ++i)
+    {
+        key.push_back(static_cast<char>(fingerprint >> (i * 8)));
+    }
+    key.append(query);
+    return key;
+}
+
+std::size_t QueryCache::entrySize(const std::string& key) noexcept
+{
+    return sizeof(Entry) + key.size() + EntryOverhead;
+}
+
+} // namespace tt09_levenshtein
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "client.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace tt09_levenshtein
+{
+
+// Bounded LRU cache of search results keyed by dictionary fingerprint and mapped query
+//
+// Entries of other dictionaries are never returned, so loading a new dictionary invalidates the cache without it
+// being cleared. The stale entries simply age out.
+class QueryCache
+{
+public:
+    struct Statistics
+    {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+    };
+
+    // Capacity is the approximate number of bytes the entries may occupy
+    explicit QueryCache(std::size_t capacity) noexcept;
+
+    std::optional<Client::Result> find(std::uint64_t fingerprint, std::string_view query);
+    void insert(std::uint64_t fingerprint, std::string_view query, const Client::Result& result);
+    void clear() noexcept;
+
+    std::size_t size() const noexcept
+    {
+        return m_entries.size();
+    }
+
+    constexpr const Statistics& statistics() const noexcept
+    {
+        return m_statistics;
+    }
+
+private:
+    struct Entry
+    {
+        std::string key;
+        Client::Result result;
+    };
+
+    // Rough per-entry overhead of the list node and hash map bucket
+    static constexpr std::size_t EntryOverhead = 96;
+
+    static std::string makeKey(std::uint64_t fingerprint, std::string_view query);
+    static std::size_t entrySize(const std::string& key) noexcept;
+
+    std::size_t m_capacity;
+    std::size_t m_size = 0;
+    std::list<Entry> m_entries;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> m_index;
+    Statistics m_statistics;
+};
+
+} // namespace tt09_levenshtein
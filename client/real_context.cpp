@@ -1,5 +1,7 @@
 #include "real_context.h"
 
+#include "tracer.h"
+
 #include <asio/steady_timer.hpp>
 #include <asio/this_coro.hpp>
 #include <asio/use_awaitable.hpp>
@@ -14,6 +16,8 @@ asio::awaitable<void> RealContext::init()
 
 asio::awaitable<void> RealContext::wait(std::chrono::nanoseconds time)
 {
+    AsyncTraceScope scope("context", "wait");
+
     auto executor = co_await asio::this_coro::executor;
 
     asio::steady_timer timer(executor);
@@ -21,4 +25,9 @@ asio::awaitable<void> RealContext::wait(std::chrono::nanoseconds time)
     co_await timer.async_wait(asio::use_awaitable);
 }
 
+std::chrono::nanoseconds RealContext::now() const noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start);
+}
+
 } // namespace tt09_levenshtein
\ No newline at end of file
@@ -10,6 +10,10 @@ class RealContext : public Context
 public:
     asio::awaitable<void> init() override;
     asio::awaitable<void> wait(std::chrono::nanoseconds time) override;
+    std::chrono::nanoseconds now() const noexcept override;
+
+private:
+    std::chrono::steady_clock::time_point m_start = std::chrono::steady_clock::now();
 };
 
 } // namespace tt09_levenshtein
\ No newline at end of file
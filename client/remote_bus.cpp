@@ -0,0 +1,116 @@
+#include "remote_bus.h"
+
+#include "big_endian.h"
+#include "bus_server.h"
+#include "tracer.h"
+
+#include <asio/buffer.hpp>
+#include <asio/connect.hpp>
+#include <asio/read.hpp>
+#include <asio/use_awaitable.hpp>
+#include <asio/write.hpp>
+#include <fmt/format.h>
+
+#include <array>
+#include <stdexcept>
+
+namespace tt09_levenshtein
+{
+
+RemoteBus::RemoteBus(asio::any_io_executor executor, const Config& config)
+    : m_config(config)
+    , m_localSocket(executor)
+    , m_tcpSocket(executor)
+{
+}
+
+asio::awaitable<void> RemoteBus::connect()
+{
+    if (m_config.socketPath)
+    {
+        co_await m_localSocket.async_connect(asio::local::stream_protocol::endpoint(m_config.socketPath->string()), asio::use_awaitable);
+    }
+    else
+    {
+        asio::ip::tcp::resolver resolver(m_tcpSocket.get_executor());
+        auto endpoints = co_await resolver.async_resolve(m_config.host, std::to_string(m_config.port), asio::use_awaitable);
+        co_await asio::async_connect(m_tcpSocket, endpoints, asio::use_awaitable);
+        m_tcpSocket.set_option(asio::ip::tcp::no_delay(true));
+    }
+}
+
+asio::awaitable<void> RemoteBus::read(std::uint32_t address, std::span<std::byte> buffer)
+{
+    AsyncTraceScope scope("bus", "read");
+    co_await transact(static_cast<std::uint8_t>(BusServer::Command::Read), address, static_cast<std::uint32_t>(buffer.size()), {}, buffer);
+}
+
+asio::awaitable<void> RemoteBus::write(std::uint32_t address, std::span<const std::byte> data)
+{
+    AsyncTraceScope scope("bus", "write");
+    co_await transact(static_cast<std::uint8_t>(BusServer::Command::Write), address, static_cast<std::uint32_t>(data.size()), data, {});
+}
+
+asio::awaitable<void> RemoteBus::load(std::uint32_t address, std::span<const std::byte> data)
+{
+    AsyncTraceScope scope("bus", "load");
+    co_await transact(static_cast<std::uint8_t>(BusServer::Command::Load), address, static_cast<std::uint32_t>(data.size()), data, {});
+}
+
+asio::awaitable<void> RemoteBus::wait(std::chrono::nanoseconds time)
+{
+    std::vector<std::byte> payload;
+    appendBigEndian(payload, static_cast<std::uint64_t>(time.count()), 8);
+    co_await transact(static_cast<std::uint8_t>(BusServer::Command::Wait), 0, static_cast<std::uint32_t>(payload.size()), payload, {});
+}
+
+asio::awaitable<void> RemoteBus::transact(std::uint8_t command, std::uint32_t address, std::uint32_t length, std::span<const std::byte> payload, std::span<std::byte> response)
+{
+    if (length > BusServer::MaxPayloadSize)
+    {
+        throw std::invalid_argument(fmt::format("Bus transaction of {} bytes exceeds the remote limit", length));
+    }
+
+    m_request.clear();
+    m_request.push_back(static_cast<std::byte>(command));
+    appendBigEndian(m_request, address, 4);
+    appendBigEndian(m_request, length, 4);
+    m_request.insert(m_request.end(), payload.begin(), payload.end());
+
+    if (m_config.socketPath)
+    {
+        co_await transact(m_localSocket, m_request, response);
+    }
+    else
+    {
+        co_await transact(m_tcpSocket, m_request, response);
+    }
+}
+
+template<typename Socket>
+asio::awaitable<void> RemoteBus::transact(Socket& socket, std::span<const std::byte> request, std::span<std::byte> response)
+{
+    co_await asio::async_write(socket, asio::buffer(request.data(), request.size()), asio::use_awaitable);
+
+    std::array<std::byte, 13> header;
+    co_await asio::async_read(socket, asio::buffer(header), asio::use_awaitable);
+
+    auto status = static_cast<BusServer::Status>(header[0]);
+    m_now = std::chrono::nanoseconds(readBigEndian(std::span(header).subspan(1, 8)));
+    auto length = static_cast<std::size_t>(readBigEndian(std::span(header).subspan(9, 4)));
+
+    if (status != BusServer::Status::Ok)
+    {
+        std::string message(length, '\0');
+        co_await asio::async_read(socket, asio::buffer(message), asio::use_awaitable);
+        throw std::runtime_error(fmt::format("Remote bus error: {}", message));
+    }
+    if (length != response.size())
+    {
+        throw std::runtime_error(fmt::format("Remote bus returned {} bytes, expected {}", length, response.size()));
+    }
+
+    co_await asio::async_read(socket, asio::buffer(response.data(), response.size()), asio::use_awaitable);
+}
+
+} // namespace tt09_levenshtein
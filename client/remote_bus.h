@@ -0,0 +1,66 @@
+#pragma once
+
+#include "bus.h"
+
+#include <asio/any_io_executor.hpp>
+#include <asio/awaitable.hpp>
+#include <asio/ip/tcp.hpp>
+#include <asio/local/stream_protocol.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace tt09_levenshtein
+{
+
+// Bus of a device hosted by a BusServer in another process
+//
+// Every call is sent as a single request and waits for its response, so a bulk load costs one round trip however
+// large the image is.
+class RemoteBus : public Bus
+{
+public:
+    struct Config
+    {
+        // Connects to the Unix domain socket if set, otherwise to the TCP port
+        std::optional<std::filesystem::path> socketPath;
+        std::string host = "127.0.0.1";
+        unsigned short port = 0;
+    };
+
+    RemoteBus(asio::any_io_executor executor, const Config& config);
+
+    asio::awaitable<void> connect();
+
+    asio::awaitable<void> read(std::uint32_t address, std::span<std::byte> buffer) override;
+    asio::awaitable<void> write(std::uint32_t address, std::span<const std::byte> data) override;
+    asio::awaitable<void> load(std::uint32_t address, std::span<const std::byte> data) override;
+
+    // Advances the device clock
+    asio::awaitable<void> wait(std::chrono::nanoseconds time);
+
+    // Device time reported by the last response
+    constexpr std::chrono::nanoseconds now() const noexcept
+    {
+        return m_now;
+    }
+
+private:
+    asio::awaitable<void> transact(std::uint8_t command, std::uint32_t address, std::uint32_t length, std::span<const std::byte> payload, std::span<std::byte> response);
+
+    template<typename Socket>
+    asio::awaitable<void> transact(Socket& socket, std::span<const std::byte> request, std::span<std::byte> response);
+
+    Config m_config;
+    asio::local::stream_protocol::socket m_localSocket;
+    asio::ip::tcp::socket m_tcpSocket;
+    std::vector<std::byte> m_request;
+    std::chrono::nanoseconds m_now = {};
+};
+
+} // namespace tt09_levenshtein
@@ -0,0 +1,30 @@
+#include "remote_context.h"
+
+#include "remote_bus.h"
+#include "tracer.h"
+
+namespace tt09_levenshtein
+{
+
+RemoteContext::RemoteContext(RemoteBus& bus) noexcept
+    : m_bus(bus)
+{
+}
+
+asio::awaitable<void> RemoteContext::init()
+{
+    co_await m_bus.connect();
+}
+
+asio::awaitable<void> RemoteContext::wait(std::chrono::nanoseconds time)
+{
+    AsyncTraceScope scope("context", "wait");
+    co_await m_bus.wait(time);
+}
+
+std::chrono::nanoseconds RemoteContext::now() const noexcept
+{
+    return m_bus.now();
+}
+
+} // namespace tt09_levenshtein
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "context.h"
+
+namespace tt09_levenshtein
+{
+
+class RemoteBus;
+
+// Clock of a device hosted by a BusServer in another process. Waiting advances the remote device
+class RemoteContext : public Context
+{
+public:
+    explicit RemoteContext(RemoteBus& bus) noexcept;
+
+    asio::awaitable<void> init() override;
+    asio::awaitable<void> wait(std::chrono::nanoseconds time) override;
+    std::chrono::nanoseconds now() const noexcept override;
+
+private:
+    RemoteBus& m_bus;
+};
+
+} // namespace tt09_levenshtein
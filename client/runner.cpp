@@ -1,13 +1,24 @@
 #include "runner.h"
 
+#include "backdoor_bus.h"
+#include "bus_server.h"
 #include "client.h"
 #include "context.h"
+#include "deletion_index.h"
 #include "icestick_spi.h"
+#include "instrumented_bus.h"
 #include "levenshtein.h"
+#include "projection.h"
+#include "query_cache.h"
 #include "real_context.h"
+#include "remote_bus.h"
+#include "remote_context.h"
+#include "search_scheduler.h"
+#include "server.h"
 #include "spi.h"
 #include "spi_bus.h"
 #include "test_set.h"
+#include "tracer.h"
 #include "unicode.h"
 #include "verilator_context.h"
 #include "verilator_spi.h"
@@ -16,6 +27,7 @@
 #include <asio/detached.hpp>
 #include <asio/io_context.hpp>
 #include <asio/this_coro.hpp>
+#include <fmt/format.h>
 #include <fmt/printf.h>
 
 #include <algorithm>
@@ -24,44 +36,89 @@
 #include <cstdio>
 #include <exception>
 #include <fstream>
+#include <iostream>
+#include <iterator>
 #include <memory>
 #include <stdexcept>
+#include <vector>
 
 namespace tt09_levenshtein
 {
 
+namespace
+{
+
+void appendJsonString(std::string& buffer, std::string_view string)
+{
+    buffer.push_back('"');
+    for (auto c : string)
+    {
+        switch (c)
+        {
+            case '"':
+                buffer.append("\\\"");
+                break;
+            case '\\':
+                buffer.append("\\\\");
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    fmt::format_to(std::back_inserter(buffer), "\\u{:04x}", static_cast<unsigned int>(c));
+                }
+                else
+                {
+                    buffer.push_back(c);
+                }
+                break;
+        }
+    }
+    buffer.push_back('"');
+}
+
+} // namespace
+
 Runner::Runner(Device device, Client::ChipSelect memoryChipSelect)
     : m_device(device)
     , m_memoryChipSelect(memoryChipSelect)
 {
 }
 
-void Runner::setVcdPath(const std::filesystem::path& vcdPath)
-{
-    m_vcdPath = vcdPath;
-}
-    
 void Runner::run(const Config& config)
 {
+    // Batch results may be written to stdout, which must then hold nothing else
+    m_log = config.batchPath ? stderr : stdout;
+
     asio::io_context ioContext;
     
     std::unique_ptr<Context> context;
     std::unique_ptr<Spi> spi;
+    std::unique_ptr<RemoteBus> remoteBus;
 
     switch (m_device)
     {
         case Device::Verilator:
         {
             std::unique_ptr<VerilatorContext> verilatorContext;
-            if (m_vcdPath)
+            if (config.tracePath)
             {
-                verilatorContext = std::make_unique<VerilatorContext>(50000000, *m_vcdPath);
+                VerilatorContext::TraceConfig traceConfig;
+                traceConfig.path = *config.tracePath;
+                traceConfig.scope = config.traceScope;
+                traceConfig.depth = config.traceDepth;
+                traceConfig.startTime = std::chrono::nanoseconds(config.traceStartTime);
+                traceConfig.stopTime = std::chrono::nanoseconds(config.traceStopTime);
+                traceConfig.startCycle = config.traceStartCycle;
+                traceConfig.stopCycle = config.traceStopCycle;
+                traceConfig.gated = config.traceSearch.has_value();
+                verilatorContext = std::make_unique<VerilatorContext>(SimulatedFrequency, traceConfig);
             }
             else
             {
-                verilatorContext = std::make_unique<VerilatorContext>(50000000);
+                verilatorContext = std::make_unique<VerilatorContext>(SimulatedFrequency);
             }
-            spi = std::make_unique<VerilatorSpi>(*verilatorContext);
+            m_verilatorContext = verilatorContext.get();
+            spi = std::make_unique<VerilatorSpi>(*verilatorContext, SimulatedSpiDivider);
             context = std::move(verilatorContext);
             break;
         }
@@ -70,24 +127,172 @@ void Runner::run(const Config& config)
             context = std::make_unique<RealContext>();
             spi = std::make_unique<IcestickSpi>(*context);
             break;
+
+        case Device::Remote:
+        {
+            RemoteBus::Config remoteConfig;
+            remoteConfig.socketPath = config.remoteSocketPath;
+            remoteConfig.host = config.remoteHost;
+            remoteConfig.port = config.remotePort;
+            remoteBus = std::make_unique<RemoteBus>(ioContext.get_executor(), remoteConfig);
+            context = std::make_unique<RemoteContext>(*remoteBus);
+            break;
+        }
     }
 
-    SpiBus bus(*spi);
+    // A remote device is driven through its server's bus, so there is no SPI interface of its own
+    std::optional<SpiBus> spiBus;
+    Bus* bus = remoteBus.get();
+    if (spi)
+    {
+        spiBus.emplace(*spi);
+        bus = &*spiBus;
+    }
 
-    Client client(*context, bus);
+    std::optional<BackdoorBus> backdoorBus;
+    if (config.backdoor)
+    {
+        if (m_verilatorContext && m_memoryChipSelect == Client::ChipSelect::CS)
+        {
+            backdoorBus.emplace(*spiBus, *m_verilatorContext);
+            bus = &*backdoorBus;
+        }
+        else
+        {
+            fmt::println(stderr, "Backdoor loading is only available with the verilator interface and memory on CS");
+        }
+    }
 
-    asio::co_spawn(ioContext, run(ioContext, *context, client, config), asio::detached);
+    std::optional<InstrumentedBus> instrumentedBus;
+    if (config.showStatistics)
+    {
+        instrumentedBus.emplace(*bus, spiBus ? &*spiBus : nullptr);
+        bus = &*instrumentedBus;
+    }
+    m_instrumentedBus = instrumentedBus ? &*instrumentedBus : nullptr;
+
+    Client client(*context, *bus);
+    client.setPollInterval(std::chrono::nanoseconds(config.pollInterval));
+    if (m_verilatorContext && config.traceSearch)
+    {
+        client.setSearchGate(*config.traceSearch, [verilatorContext = m_verilatorContext](bool open)
+        {
+            verilatorContext->setTraceGate(open);
+        });
+    }
+
+    std::optional<QueryCache> cache;
+    if (config.cacheSize != 0)
+    {
+        cache.emplace(config.cacheSize);
+        client.setCache(&*cache);
+    }
+
+    std::optional<DeletionIndex> index;
+    if (config.indexDistance)
+    {
+        index.emplace(*config.indexDistance);
+        client.setIndex(&*index);
+    }
+
+    std::optional<Tracer> tracer;
+    if (config.timelinePath)
+    {
+        tracer.emplace(*context);
+    }
+
+    asio::co_spawn(ioContext, run(ioContext, *context, *bus, client, config), asio::detached);
 
     ioContext.run();
+
+    if (tracer)
+    {
+        tracer->write(*config.timelinePath);
+    }
+
+    m_instrumentedBus = nullptr;
+    m_verilatorContext = nullptr;
+    if (instrumentedBus)
+    {
+        printStatistics(m_log, *instrumentedBus);
+    }
+
+    const auto& totals = client.counterTotals();
+    if (config.showCounters && totals.searches != 0)
+    {
+        fmt::println(
+            m_log,
+            "Engine average over {} searches: \033[36m{}\033[0m cycles, {} dictionary stalls, {} vector stalls",
+            totals.searches,
+            totals.cycles / totals.searches,
+            totals.dictionaryStalls / totals.searches,
+            totals.vectorStalls / totals.searches);
+    }
+
+    if (cache)
+    {
+        const auto& statistics = cache->statistics();
+        fmt::println(m_log, "Query cache: {} hits, {} misses, {} evictions, {} entries", statistics.hits, statistics.misses, statistics.evictions, cache->size());
+    }
+
+    if (index)
+    {
+        const auto& statistics = index->statistics();
+        fmt::println(m_log, "Deletion index: {} hits, {} misses, {} entries for {} words", statistics.hits, statistics.misses, index->entryCount(), index->size());
+    }
+
+    if (config.showProjection)
+    {
+        if (m_device == Device::Verilator)
+        {
+            Projection::Config projectionConfig;
+            projectionConfig.simulatedCoreClock = SimulatedFrequency;
+            projectionConfig.simulatedSpiDivider = SimulatedSpiDivider;
+            projectionConfig.coreClock = config.projectionCoreClock;
+            projectionConfig.spiClock = config.projectionSpiClock;
+
+            Projection(projectionConfig).print(m_log, client.phaseTimes(), client.dictionarySize());
+        }
+        else
+        {
+            fmt::println(stderr, "Projection is only available with the verilator interface");
+        }
+    }
 }
 
-asio::awaitable<void> Runner::run(asio::io_context& ioContext, Context& context, Client& client, const Config& config)
+asio::awaitable<void> Runner::run(asio::io_context& ioContext, Context& context, Bus& bus, Client& client, const Config& config)
 {
     try
     {
-        co_await context.init();
+        // A restored snapshot already holds the cleared vector map and the loaded dictionary
+        bool restored = m_verilatorContext && config.restoreStatePath;
+        if (config.restoreStatePath && !m_verilatorContext)
+        {
+            fmt::println(stderr, "Restoring state is only available with the verilator interface");
+        }
+        if (restored)
+        {
+            fmt::println(m_log, "Restoring state: {}", config.restoreStatePath->string());
+            co_await m_verilatorContext->restore(*config.restoreStatePath);
+        }
+        else
+        {
+            co_await context.init();
+        }
+
+        // The device is left as it is for the clients, which initialize it and load their dictionary themselves
+        if (config.serveDeviceSocketPath || config.serveDevicePort)
+        {
+            co_await serveDevice(context, bus, config);
+            ioContext.stop();
+            co_return;
+        }
 
-        co_await init(client, config);
+        co_await init(client, !restored && !config.noClear, config.frontCoding);
+        if (config.showCounters && !client.hasWideRegisters())
+        {
+            fmt::println(stderr, "The device has no performance counters");
+        }
 
         if (config.dictionaryPath)
         {
@@ -95,10 +300,19 @@ asio::awaitable<void> Runner::run(asio::io_context& ioContext, Context& context,
             createCharset();
             mapDictionaryToCharset();
 
-            if (!config.noLoadDictionary)
+            if (!restored && !config.noLoadDictionary)
             {
                 co_await loadDictionary(client);
             }
+            else
+            {
+                client.adoptDictionary(m_mappedDictionary);
+            }
+
+            if (config.appendPath)
+            {
+                co_await appendDictionary(client, *config.appendPath);
+            }
 
             if (config.verifyDictionary)
             {
@@ -106,6 +320,19 @@ asio::awaitable<void> Runner::run(asio::io_context& ioContext, Context& context,
             }
         }
 
+        if (config.saveStatePath)
+        {
+            if (m_verilatorContext)
+            {
+                fmt::println(m_log, "Saving state: {}", config.saveStatePath->string());
+                m_verilatorContext->save(*config.saveStatePath);
+            }
+            else
+            {
+                fmt::println(stderr, "Saving state is only available with the verilator interface");
+            }
+        }
+
         if (!config.searchWord.empty())
         {
             co_await search(client, config, config.searchWord);
@@ -115,6 +342,16 @@ asio::awaitable<void> Runner::run(asio::io_context& ioContext, Context& context,
         {
             co_await runTest(client, config);
         }
+
+        if (config.batchPath)
+        {
+            co_await runBatch(context, client, config);
+        }
+
+        if (config.listenSocketPath || config.listenPort)
+        {
+            co_await serve(client, config);
+        }
     }
     catch (const std::exception& exception)
     {
@@ -123,13 +360,18 @@ asio::awaitable<void> Runner::run(asio::io_context& ioContext, Context& context,
     ioContext.stop();
 }
 
-asio::awaitable<void> Runner::init(Client& client, const Config& config)
+asio::awaitable<void> Runner::init(Client& client, bool clearVectorMap, bool frontCoding)
 {
-    fmt::println("Initializing device");
+    fmt::println(m_log, "Initializing device");
     auto t1 = std::chrono::high_resolution_clock::now();
-    co_await client.init(m_memoryChipSelect, !config.noClear);
+    co_await client.init(m_memoryChipSelect, clearVectorMap);
+    client.setFrontCoding(frontCoding);
     auto t2 = std::chrono::high_resolution_clock::now();
-    fmt::println("Initialized device in \033[36m{}\033[0m ms", std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count());
+    if (m_instrumentedBus)
+    {
+        m_instrumentedBus->setLayout(client.vectorMapAddress(), client.dictionaryAddress());
+    }
+    fmt::println(m_log, "Initialized device in \033[36m{}\033[0m ms", std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count());
 }
 
 asio::awaitable<void> Runner::search(Client& client, const Config& config, std::string_view word)
@@ -142,35 +384,73 @@ asio::awaitable<void> Runner::search(Client& client, const Config& config, std::
 
     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
 
-    fmt::print("Best match for \033[33m{}\033[0m is ", word);
+    fmt::print(m_log, "Best match for \033[33m{}\033[0m is ", word);
     if (result.index < m_dictionary.size())
     {
-        fmt::print("\033[33m{}\033[0m", m_dictionary.at(result.index));
+        fmt::print(m_log, "\033[33m{}\033[0m", m_dictionary.at(result.index));
     }
     else
     {
-        fmt::print("index \033[33m{}\033[0m", result.index);
+        fmt::print(m_log, "index \033[33m{}\033[0m", result.index);
     }
-    fmt::print(" with a distance of \033[35m{}\033[0m.", result.distance);
+    fmt::print(m_log, " with a distance of \033[35m{}\033[0m.", result.distance);
     
     if (result.index < m_dictionary.size() && config.verifySearch)
     {
         auto distance = levenshtein(Unicode::toUTF32(word), Unicode::toUTF32(m_dictionary.at(result.index)));
         if (result.distance == distance)
         {
-            fmt::print(" [\033[32mCORRECT\033[0m]");
+            fmt::print(m_log, " [\033[32mCORRECT\033[0m]");
         }
         else
         {
-            fmt::print(" [\033[31mINCORRECT\033[0m should have been \033[35m{}\033[0m]", distance);
+            fmt::print(m_log, " [\033[31mINCORRECT\033[0m should have been \033[35m{}\033[0m]", distance);
         }
     }
-    fmt::println(" Search took \033[36m{}\033[0m ms", elapsed.count());
+    fmt::print(m_log, " Search took \033[36m{}\033[0m ms", elapsed.count());
+    switch (result.source)
+    {
+        case Client::Source::Device:
+            fmt::println(m_log, "");
+            break;
+
+        case Client::Source::Cache:
+            fmt::println(m_log, " (query cache)");
+            break;
+
+        case Client::Source::Index:
+            fmt::println(m_log, " (deletion index)");
+            break;
+    }
+
+    // The counters are still those of the last search which ran on the device
+    if (config.showCounters && client.hasWideRegisters() && result.source == Client::Source::Device)
+    {
+        const auto& counters = client.counters();
+        fmt::println(
+            m_log,
+            "  Engine: \033[36m{}\033[0m cycles, {} dictionary stalls, {} vector stalls, {} dictionary bytes, {} words",
+            counters.cycles,
+            counters.dictionaryStalls,
+            counters.vectorStalls,
+            counters.dictionaryBytes,
+            counters.words);
+    }
 }
 
 asio::awaitable<void> Runner::runTest(Client& client, const Config& config)
 {
+    std::vector<std::string> corpus;
+    if (config.testCorpusPath)
+    {
+        auto words = readWords(*config.testCorpusPath);
+        corpus.assign(words.begin(), words.end());
+    }
+
     TestSet::Config testConfig;
+    testConfig.seed = config.testSeed;
+    testConfig.charSkew = config.testCharSkew;
+    testConfig.corpus = corpus;
     testConfig.minChar = 'a';
     testConfig.maxChar = 'a' + config.testAlphabetSize - 1;
     testConfig.minDictionaryWordLength = 1;
@@ -179,11 +459,18 @@ asio::awaitable<void> Runner::runTest(Client& client, const Config& config)
     testConfig.minSearchWordLength = 1;
     testConfig.maxSearchWordLength = client.maxLength();
     testConfig.searchWordCount = config.testSearchCount;
+    testConfig.searchEdits = config.testSearchEdits;
 
+    auto t1 = std::chrono::high_resolution_clock::now();
     TestSet testSet(testConfig);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    fmt::println(m_log, "Generated test set with seed {} in \033[36m{}\033[0m ms", config.testSeed, std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count());
 
-    auto testDictionary = testSet.dictionaryWords();
-    m_dictionary.assign(testDictionary.begin(), testDictionary.end());
+    m_dictionary.clear();
+    for (const auto& word : testSet.dictionaryWords())
+    {
+        m_dictionary.push_back(word);
+    }
     
     createCharset();
     mapDictionaryToCharset();
@@ -199,19 +486,199 @@ asio::awaitable<void> Runner::runTest(Client& client, const Config& config)
     }
 }
 
+asio::awaitable<void> Runner::runBatch(Context& context, Client& client, const Config& config)
+{
+    // Results are buffered and written in large chunks, so that output does not slow down the searches
+    constexpr std::size_t FlushThreshold = 64 * 1024;
+
+    std::ifstream inputFile;
+    if (*config.batchPath != "-")
+    {
+        inputFile.open(config.batchPath->string().c_str());
+        if (!inputFile.good())
+        {
+            throw std::runtime_error(fmt::format("Error opening batch file: {}", config.batchPath->string()));
+        }
+    }
+    std::istream& input = inputFile.is_open() ? inputFile : std::cin;
+
+    std::FILE* output = stdout;
+    if (config.batchOutputPath)
+    {
+        output = std::fopen(config.batchOutputPath->string().c_str(), "w");
+        if (!output)
+        {
+            throw std::runtime_error(fmt::format("Error opening batch output file: {}", config.batchOutputPath->string()));
+        }
+    }
+
+    std::string buffer;
+    auto flush = [&]()
+    {
+        std::fwrite(buffer.data(), 1, buffer.size(), output);
+        buffer.clear();
+    };
+
+    std::vector<std::chrono::nanoseconds> latencies;
+    std::uint64_t errors = 0;
+
+    auto t1 = context.now();
+
+    std::string line;
+    while (std::getline(input, line))
+    {
+        std::string_view query = line;
+        while (!query.empty() && std::isspace(query.back()))
+        {
+            query.remove_suffix(1);
+        }
+        if (query.empty())
+        {
+            continue;
+        }
+
+        auto searchStart = context.now();
+        std::optional<Client::Result> result;
+        std::string error;
+        try
+        {
+            result = co_await client.search(mapStringToCharset(query));
+        }
+        catch (const std::exception& exception)
+        {
+            error = exception.what();
+            errors++;
+        }
+        latencies.push_back(context.now() - searchStart);
+
+        std::string_view word;
+        if (result && result->index < m_dictionary.size())
+        {
+            word = m_dictionary[result->index];
+        }
+
+        if (config.batchJson)
+        {
+            buffer.append("{\"query\":");
+            appendJsonString(buffer, query);
+            if (result)
+            {
+                fmt::format_to(std::back_inserter(buffer), ",\"index\":{},\"word\":", result->index);
+                appendJsonString(buffer, word);
+                fmt::format_to(std::back_inserter(buffer), ",\"distance\":{}}}\n", result->distance);
+            }
+            else
+            {
+                buffer.append(",\"error\":");
+                appendJsonString(buffer, error);
+                buffer.append("}\n");
+            }
+        }
+        else if (result)
+        {
+            fmt::format_to(std::back_inserter(buffer), "{}\t{}\t{}\t{}\t\n", query, result->index, word, result->distance);
+        }
+        else
+        {
+            fmt::format_to(std::back_inserter(buffer), "{}\t\t\t\t{}\n", query, error);
+        }
+
+        if (buffer.size() >= FlushThreshold)
+        {
+            flush();
+        }
+    }
+
+    auto t2 = context.now();
+
+    flush();
+    if (output != stdout)
+    {
+        std::fclose(output);
+    }
+    else
+    {
+        std::fflush(output);
+    }
+
+    if (latencies.empty())
+    {
+        fmt::println(stderr, "Batch contained no queries");
+        co_return;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p)
+    {
+        auto index = static_cast<std::size_t>(p * (latencies.size() - 1) + 0.5);
+        return std::chrono::duration<double, std::milli>(latencies[index]).count();
+    };
+
+    auto elapsed = std::chrono::duration<double>(t2 - t1).count();
+    fmt::println(stderr, "Ran {} queries ({} errors) in {:.3f} s: {:.1f} queries/s", latencies.size(), errors, elapsed, latencies.size() / elapsed);
+    fmt::println(stderr, "Latency p50 {:.3f} ms, p90 {:.3f} ms, p99 {:.3f} ms, max {:.3f} ms", percentile(0.5), percentile(0.9), percentile(0.99), percentile(1.0));
+}
+
+asio::awaitable<void> Runner::serve(Client& client, const Config& config)
+{
+    Server::Config serverConfig;
+    serverConfig.socketPath = config.listenSocketPath;
+    serverConfig.port = config.listenPort;
+
+    auto executor = co_await asio::this_coro::executor;
+    SearchScheduler scheduler(executor, client, config.shortestFirst ? SearchScheduler::Order::ShortestFirst : SearchScheduler::Order::Fifo);
+
+    Server server(serverConfig,
+        [this, &scheduler](std::string query) -> asio::awaitable<Server::Response>
+        {
+            auto result = co_await scheduler.search(mapStringToCharset(query));
+
+            Server::Response response;
+            response.distance = result.distance;
+            response.index = result.index;
+            if (result.index < m_dictionary.size())
+            {
+                response.word = m_dictionary.at(result.index);
+            }
+            co_return response;
+        });
+
+    co_await server.run();
+}
+
+asio::awaitable<void> Runner::serveDevice(Context& context, Bus& bus, const Config& config)
+{
+    BusServer::Config serverConfig;
+    serverConfig.socketPath = config.serveDeviceSocketPath;
+    serverConfig.port = config.serveDevicePort;
+
+    BusServer server(serverConfig, bus, context);
+    co_await server.run();
+}
+
 void Runner::readDictionary(const std::filesystem::path& path)
 {
-    fmt::println("Reading dictionary: {}", path.string());
+    fmt::println(m_log, "Reading dictionary: {}", path.string());
+    TraceScope scope("host", "readDictionary");
 
     auto t1 = std::chrono::high_resolution_clock::now();
 
+    m_dictionary = readWords(path);
+
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    fmt::println(m_log, "Read dictionary in \033[36m{}\033[0m ms", std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count());
+}
+
+WordList Runner::readWords(const std::filesystem::path& path)
+{
     std::ifstream stream(path.string().c_str());
     if (!stream.good())
     {
         throw std::runtime_error(fmt::format("Error opening dictionary: {}", path.string()));
     }
 
-    m_dictionary.clear();
+    WordList words;
 
     std::string line;
     while (std::getline(stream, line).good())
@@ -222,20 +689,27 @@ void Runner::readDictionary(const std::filesystem::path& path)
             word.remove_suffix(1);
         }
 
-        m_dictionary.emplace_back(word);
+        words.push_back(word);
     }
 
-    auto t2 = std::chrono::high_resolution_clock::now();
-
-    fmt::println("Read dictionary in \033[36m{}\033[0m ms", std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count());
+    return words;
 }
 
 void Runner::createCharset()
 {
-    fmt::println("Creating character set");
+    fmt::println(m_log, "Creating character set");
+    TraceScope scope("host", "createCharset");
     auto t1 = std::chrono::high_resolution_clock::now();
     m_charset.clear();
-    for (const auto& word : m_dictionary)
+    extendCharset(m_dictionary);
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    fmt::println(m_log, "Created character set of {} characters in \033[36m{}\033[0m ms", m_charset.size(), std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count());
+}
+
+void Runner::extendCharset(const WordList& words)
+{
+    for (const auto& word : words)
     {
         for (auto c : Unicode::toUTF32(word))
         {
@@ -250,44 +724,78 @@ void Runner::createCharset()
             }
         }
     }
-    auto t2 = std::chrono::high_resolution_clock::now();
-
-    fmt::println("Created character set of {} characters in \033[36m{}\033[0m ms", m_charset.size(), std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count());
 }
 
 void Runner::mapDictionaryToCharset()
 {
     m_mappedDictionary.clear();
 
-    fmt::println("Mapping dictionary to character set");
+    fmt::println(m_log, "Mapping dictionary to character set");
+    TraceScope scope("host", "mapDictionaryToCharset");
 
     auto t1 = std::chrono::high_resolution_clock::now();
     m_mappedDictionary.clear();
-    m_mappedDictionary.reserve(m_dictionary.size());
+    m_mappedDictionary.reserve(m_dictionary.size(), m_dictionary.bytes().size());
     for (const auto& string : m_dictionary)
     {
         m_mappedDictionary.push_back(mapStringToCharset(string));
     }
     auto t2 = std::chrono::high_resolution_clock::now();
-    fmt::println("Mapped dictionary in \033[36m{}\033[0m ms", std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count());
+    fmt::println(m_log, "Mapped dictionary in \033[36m{}\033[0m ms", std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count());
 }
 
 asio::awaitable<void> Runner::loadDictionary(Client& client)
 {
-    fmt::println("Loading dictionary onto device");
+    fmt::println(m_log, "Loading dictionary onto device");
     auto t1 = std::chrono::high_resolution_clock::now();
     co_await client.loadDictionary(m_mappedDictionary);
     auto t2 = std::chrono::high_resolution_clock::now();
-    fmt::println("Loaded dictionary in \033[36m{}\033[0m ms", std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count());
+    fmt::println(m_log, "Loaded dictionary in \033[36m{}\033[0m ms", std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count());
+}
+
+asio::awaitable<void> Runner::appendDictionary(Client& client, const std::filesystem::path& path)
+{
+    fmt::println(m_log, "Appending words: {}", path.string());
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    // Existing characters keep their codes, so the words already on the device remain valid
+    auto words = readWords(path);
+    extendCharset(words);
+
+    WordList mappedWords;
+    mappedWords.reserve(words.size(), words.bytes().size());
+    for (const auto& word : words)
+    {
+        mappedWords.push_back(mapStringToCharset(word));
+    }
+
+    auto appendCount = mappedWords.size();
+    bool partitioned = client.engineCount() > 1;
+    if (!partitioned)
+    {
+        co_await client.appendWords(mappedWords);
+    }
+
+    m_dictionary.append(words);
+    m_mappedDictionary.append(mappedWords);
+
+    // Every partition shifts when words are added, so a partitioned dictionary has to be laid out again
+    if (partitioned)
+    {
+        co_await client.loadDictionary(m_mappedDictionary);
+    }
+
+    auto t2 = std::chrono::high_resolution_clock::now();
+    fmt::println(m_log, "Appended {} words in \033[36m{}\033[0m ms", appendCount, std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count());
 }
 
 asio::awaitable<void> Runner::verifyDictionary(Client& client)
 {
-    fmt::println("Verifying dictionary");
+    fmt::println(m_log, "Verifying dictionary");
     auto t1 = std::chrono::high_resolution_clock::now();
     co_await client.verifyDictionary(m_mappedDictionary);
     auto t2 = std::chrono::high_resolution_clock::now();
-    fmt::println("Verified dictionary in \033[36m{}\033[0m ms", std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count());
+    fmt::println(m_log, "Verified dictionary in \033[36m{}\033[0m ms", std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count());
 }
 
 std::string Runner::mapStringToCharset(std::string_view string) const
@@ -310,4 +818,30 @@ std::string Runner::mapStringToCharset(std::string_view string) const
     return buffer;
 }
 
+void Runner::printStatistics(std::FILE* file, const InstrumentedBus& bus)
+{
+    auto statistics = bus.snapshot();
+
+    fmt::println(file, "Bus statistics:");
+    fmt::println(file, "  {:<10} {:>12} {:>12} {:>14} {:>14}", "Region", "Reads", "Writes", "Bytes read", "Bytes written");
+    for (std::size_t i = 0; i != InstrumentedBus::RegionCount; ++i)
+    {
+        const auto& region = statistics.regions[i];
+        fmt::println(file, "  {:<10} {:>12} {:>12} {:>14} {:>14}", InstrumentedBus::regionName(static_cast<InstrumentedBus::Region>(i)), region.reads, region.writes, region.bytesRead, region.bytesWritten);
+    }
+    fmt::println(file, "  SPI sync retries: {}", statistics.syncRetries);
+
+    fmt::println(file, "Bus latency:");
+    fmt::println(file, "  {:<16} {:>12} {:>12}", "Latency", "Reads", "Writes");
+    for (std::size_t i = 0; i != InstrumentedBus::LatencyBucketCount; ++i)
+    {
+        if (statistics.readLatency[i] == 0 && statistics.writeLatency[i] == 0)
+        {
+            continue;
+        }
+        auto range = i == 0 ? std::string("< 1 us") : fmt::format("< {} us", 1ULL << i);
+        fmt::println(file, "  {:<16} {:>12} {:>12}", range, statistics.readLatency[i], statistics.writeLatency[i]);
+    }
+}
+
 } // namespace tt09_levenshtein
\ No newline at end of file
@@ -1,20 +1,29 @@
 #pragma once
 
 #include "client.h"
+#include "word_list.h"
 
 #include <asio/awaitable.hpp>
 #include <asio/io_context.hpp>
 
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <filesystem>
+#include <limits>
 #include <map>
 #include <optional>
 #include <string_view>
 #include <string>
+#include <vector>
 
 namespace tt09_levenshtein
 {
 
+class Bus;
 class Context;
+class InstrumentedBus;
+class VerilatorContext;
 
 class Runner
 {
@@ -22,45 +31,95 @@ public:
     enum class Device
     {
         Verilator,
-        Icestick
+        Icestick,
+        Remote
     };
     struct Config
     {
         Device device = Device::Verilator;
         std::optional<std::filesystem::path> dictionaryPath;
+        std::optional<std::filesystem::path> appendPath;
+        std::optional<std::filesystem::path> timelinePath;
+        std::optional<std::filesystem::path> tracePath;
+        std::optional<std::filesystem::path> saveStatePath;
+        std::optional<std::filesystem::path> restoreStatePath;
+        std::optional<std::filesystem::path> batchPath;
+        std::optional<std::filesystem::path> batchOutputPath;
+        bool batchJson = false;
+        std::optional<std::filesystem::path> listenSocketPath;
+        std::optional<unsigned short> listenPort;
+        bool shortestFirst = false;
+        std::optional<std::filesystem::path> remoteSocketPath;
+        std::string remoteHost = "127.0.0.1";
+        unsigned short remotePort = 0;
+        std::optional<std::filesystem::path> serveDeviceSocketPath;
+        std::optional<unsigned short> serveDevicePort;
+        std::string traceScope;
+        int traceDepth = 99;
+        std::int64_t traceStartTime = 0;
+        std::int64_t traceStopTime = std::numeric_limits<std::int64_t>::max();
+        std::uint64_t traceStartCycle = 0;
+        std::uint64_t traceStopCycle = std::numeric_limits<std::uint64_t>::max();
+        std::optional<unsigned int> traceSearch;
         std::string searchWord;
         bool noClear = false;
         bool noLoadDictionary = false;
         bool runTest = false;
         bool verifyDictionary = false;
         bool verifySearch = false;
+        bool showStatistics = false;
+        bool showProjection = false;
+        bool showCounters = false;
+        bool backdoor = false;
+        bool frontCoding = false;
+        std::size_t cacheSize = 0;
+        std::optional<unsigned int> indexDistance;
+        std::int64_t pollInterval = 10000;
+        unsigned long int projectionCoreClock = 50000000;
+        unsigned long int projectionSpiClock = 12500000;
         unsigned int testAlphabetSize = 6;
         unsigned int testDictionarySize = 1024;
         unsigned int testSearchCount = 256;
+        std::uint64_t testSeed = 0;
+        double testCharSkew = 0.0;
+        std::optional<std::filesystem::path> testCorpusPath;
+        unsigned int testSearchEdits = 0;
     };
 
     Runner(Device device, Client::ChipSelect memoryChipSelect);
-    void setVcdPath(const std::filesystem::path& vcdPath);
-    
+
     void run(const Config& config);
 
 private:
-    asio::awaitable<void> run(asio::io_context& ioContext, Context& context, Client& client, const Config& config);
-    asio::awaitable<void> init(Client& client, const Config& config);
+    static constexpr unsigned long int SimulatedFrequency = 50000000;
+    static constexpr unsigned int SimulatedSpiDivider = 4;
+
+    asio::awaitable<void> run(asio::io_context& ioContext, Context& context, Bus& bus, Client& client, const Config& config);
+    asio::awaitable<void> init(Client& client, bool clearVectorMap, bool frontCoding);
     void readDictionary(const std::filesystem::path& path);
+    static WordList readWords(const std::filesystem::path& path);
     void createCharset();
+    void extendCharset(const WordList& words);
     void mapDictionaryToCharset();
     asio::awaitable<void> loadDictionary(Client& client);
+    asio::awaitable<void> appendDictionary(Client& client, const std::filesystem::path& path);
     asio::awaitable<void> verifyDictionary(Client& client);
     asio::awaitable<void> search(Client& client, const Config& config, std::string_view word);
     asio::awaitable<void> runTest(Client& client, const Config& config);
+    asio::awaitable<void> runBatch(Context& context, Client& client, const Config& config);
+    asio::awaitable<void> serve(Client& client, const Config& config);
+    asio::awaitable<void> serveDevice(Context& context, Bus& bus, const Config& config);
     std::string mapStringToCharset(std::string_view string) const;
+    static void printStatistics(std::FILE* file, const InstrumentedBus& bus);
 
     Device m_device;
     Client::ChipSelect m_memoryChipSelect;
-    std::optional<std::filesystem::path> m_vcdPath;
-    std::vector<std::string> m_dictionary;
-    std::vector<std::string> m_mappedDictionary;
+    InstrumentedBus* m_instrumentedBus = nullptr;
+    VerilatorContext* m_verilatorContext = nullptr;
+    // Progress messages and statistics
+    std::FILE* m_log = stdout;
+    WordList m_dictionary;
+    WordList m_mappedDictionary;
     std::map<char32_t, char> m_charset;
 };
 
@@ -0,0 +1,105 @@
+#include "search_scheduler.h"
+
+#include <asio/associated_executor.hpp>
+#include <asio/co_spawn.hpp>
+#include <asio/detached.hpp>
+#include <asio/post.hpp>
+
+#include <utility>
+
+namespace tt09_levenshtein
+{
+
+SearchScheduler::SearchScheduler(asio::any_io_executor executor, Client& client, Order order)
+    : m_strand(asio::make_strand(executor))
+    , m_client(client)
+    , m_order(order)
+{
+}
+
+void SearchScheduler::enqueue(std::string word, Handler handler)
+{
+    asio::post(m_strand,
+        [this, word = std::move(word), handler = std::move(handler)]() mutable
+        {
+            auto it = m_pending.find(word);
+            if (it != m_pending.end())
+            {
+                it->second.push_back(std::move(handler));
+                m_coalesced++;
+                return;
+            }
+
+            m_pending[word].push_back(std::move(handler));
+            if (m_order == Order::ShortestFirst)
+            {
+                m_shortestFirst.emplace(word.size(), std::move(word));
+            }
+            else
+            {
+                m_fifo.push_back(std::move(word));
+            }
+
+            if (!m_running)
+            {
+                m_running = true;
+                asio::co_spawn(m_strand, process(), asio::detached);
+            }
+        });
+}
+
+std::string SearchScheduler::next()
+{
+    std::string word;
+    if (m_order == Order::ShortestFirst)
+    {
+        word = std::move(m_shortestFirst.begin()->second);
+        m_shortestFirst.erase(m_shortestFirst.begin());
+    }
+    else
+    {
+        word = std::move(m_fifo.front());
+        m_fifo.pop_front();
+    }
+    return word;
+}
+
+asio::awaitable<void> SearchScheduler::process()
+{
+    while (!m_fifo.empty() || !m_shortestFirst.empty())
+    {
+        auto word = next();
+
+        std::exception_ptr exception;
+        Client::Result result = {};
+        try
+        {
+            result = co_await m_client.search(word);
+        }
+        catch (...)
+        {
+            exception = std::current_exception();
+        }
+
+        // Callers that joined while the search was in progress receive the same result
+        auto handlers = std::move(m_pending.extract(word).mapped());
+        for (auto& handler : handlers)
+        {
+            complete(std::move(handler), exception, result);
+        }
+    }
+
+    m_running = false;
+}
+
+void SearchScheduler::complete(Handler handler, std::exception_ptr exception, Client::Result result)
+{
+    auto executor = asio::get_associated_executor(handler, m_strand);
+    asio::post(executor,
+        [handler = std::move(handler), exception, result]() mutable
+        {
+            std::move(handler)(exception, result);
+        });
+}
+
+} // namespace tt09_levenshtein
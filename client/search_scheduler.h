@@ -0,0 +1,87 @@
+#pragma once
+
+#include "client.h"
+
+#include <asio/any_completion_handler.hpp>
+#include <asio/any_io_executor.hpp>
+#include <asio/async_result.hpp>
+#include <asio/awaitable.hpp>
+#include <asio/strand.hpp>
+#include <asio/use_awaitable.hpp>
+#include <asio/use_future.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace tt09_levenshtein
+{
+
+// Queues searches from any number of coroutines or threads and runs them on the client one at a time
+//
+// All state is owned by a strand, so searches may be submitted from any thread. A search for a word that is already
+// queued or in progress is not queued again; its caller receives the result of the pending search instead.
+class SearchScheduler
+{
+public:
+    enum class Order
+    {
+        Fifo,
+        ShortestFirst
+    };
+
+    SearchScheduler(asio::any_io_executor executor, Client& client, Order order = Order::Fifo);
+
+    // Completion signature is void(std::exception_ptr, Client::Result)
+    template<typename CompletionToken>
+    auto asyncSearch(std::string word, CompletionToken&& token)
+    {
+        return asio::async_initiate<CompletionToken, void(std::exception_ptr, Client::Result)>(
+            [this](auto handler, std::string word)
+            {
+                enqueue(std::move(word), Handler(std::move(handler)));
+            },
+            token,
+            std::move(word));
+    }
+
+    asio::awaitable<Client::Result> search(std::string word)
+    {
+        co_return co_await asyncSearch(std::move(word), asio::use_awaitable);
+    }
+
+    std::future<Client::Result> searchFuture(std::string word)
+    {
+        return asyncSearch(std::move(word), asio::use_future);
+    }
+
+    // Number of searches answered by a search that was already pending. Only safe to read on the strand
+    constexpr std::uint64_t coalesced() const noexcept
+    {
+        return m_coalesced;
+    }
+
+private:
+    using Handler = asio::any_completion_handler<void(std::exception_ptr, Client::Result)>;
+
+    void enqueue(std::string word, Handler handler);
+    std::string next();
+    asio::awaitable<void> process();
+    void complete(Handler handler, std::exception_ptr exception, Client::Result result);
+
+    asio::strand<asio::any_io_executor> m_strand;
+    Client& m_client;
+    Order m_order;
+    bool m_running = false;
+    std::uint64_t m_coalesced = 0;
+    std::map<std::string, std::vector<Handler>> m_pending;
+    std::deque<std::string> m_fifo;
+    std::multimap<std::size_t, std::string> m_shortestFirst;
+};
+
+} // namespace tt09_levenshtein
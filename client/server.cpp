@@ -0,0 +1,82 @@
+#include "server.h"
+
+#include "big_endian.h"
+
+#include <asio/buffer.hpp>
+#include <asio/read.hpp>
+#include <asio/use_awaitable.hpp>
+#include <asio/write.hpp>
+
+#include <array>
+#include <exception>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace tt09_levenshtein
+{
+
+Server::Server(const Config& config, SearchHandler searchHandler)
+    : m_listener(config, "search")
+    , m_searchHandler(std::move(searchHandler))
+{
+}
+
+asio::awaitable<void> Server::run()
+{
+    co_await m_listener.run(
+        [this](auto socket)
+        {
+            return serve(std::move(socket));
+        });
+}
+
+template<typename Socket>
+asio::awaitable<void> Server::serve(Socket socket)
+{
+    try
+    {
+        while (true)
+        {
+            std::array<std::uint8_t, 2> header;
+            co_await asio::async_read(socket, asio::buffer(header), asio::use_awaitable);
+
+            std::string query(readBigEndian(std::span(header)), '\0');
+            co_await asio::async_read(socket, asio::buffer(query), asio::use_awaitable);
+
+            auto response = co_await search(std::move(query));
+            if (response.word.size() > 0xFFFF)
+            {
+                response.word.resize(0xFFFF);
+            }
+
+            std::vector<std::uint8_t> frame;
+            frame.reserve(6 + response.word.size());
+            frame.push_back(static_cast<std::uint8_t>(response.status));
+            frame.push_back(response.distance);
+            appendBigEndian(frame, response.index, 2);
+            appendBigEndian(frame, response.word.size(), 2);
+            frame.insert(frame.end(), response.word.begin(), response.word.end());
+
+            co_await asio::async_write(socket, asio::buffer(frame), asio::use_awaitable);
+        }
+    }
+    catch (const std::exception&)
+    {
+        // Connection closed
+    }
+}
+
+asio::awaitable<Server::Response> Server::search(std::string query)
+{
+    try
+    {
+        co_return co_await m_searchHandler(std::move(query));
+    }
+    catch (const std::exception& exception)
+    {
+        co_return Response{Status::Error, 0, 0, exception.what()};
+    }
+}
+
+} // namespace tt09_levenshtein
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "listener.h"
+
+#include <asio/awaitable.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace tt09_levenshtein
+{
+
+// Serves searches to any number of connections over a Unix domain socket and/or a TCP port on the loopback address
+//
+// A request is a 16-bit big endian length followed by the query in UTF-8. Each request is answered, in order, with
+// a status byte, the distance, the 16-bit big endian index and a 16-bit big endian length followed by the matched
+// word in UTF-8. On error, the index and distance are zero and the word holds the error message.
+//
+// Connections are served concurrently, so the search handler must serialize searches on the device itself.
+class Server
+{
+public:
+    enum class Status : std::uint8_t
+    {
+        Ok = 0,
+        Error = 1
+    };
+
+    struct Response
+    {
+        Status status = Status::Ok;
+        std::uint8_t distance = 0;
+        std::uint16_t index = 0;
+        std::string word;
+    };
+
+    using Config = Listener::Config;
+
+    using SearchHandler = std::function<asio::awaitable<Response>(std::string query)>;
+
+    Server(const Config& config, SearchHandler searchHandler);
+
+    // Serves until SIGINT or SIGTERM is received
+    asio::awaitable<void> run();
+
+private:
+    template<typename Socket>
+    asio::awaitable<void> serve(Socket socket);
+
+    asio::awaitable<Response> search(std::string query);
+
+    Listener m_listener;
+    SearchHandler m_searchHandler;
+};
+
+} // namespace tt09_levenshtein
@@ -1,6 +1,7 @@
 #include "spi_bus.h"
 
 #include "spi.h"
+#include "tracer.h"
 
 #include <fmt/format.h>
 #ifdef SPI_BUS_DEBUG
@@ -44,6 +45,8 @@ asio::awaitable<std::byte> SpiBus::execute(std::uint32_t command)
 
         co_await m_spi.xmit(data, buffer);
 
+        AsyncTraceScope syncScope("bus", "sync");
+
         auto syncIt = buffer.end();
         for (unsigned int retries = 0; retries != 256; ++retries)
         {
@@ -70,6 +73,7 @@ asio::awaitable<std::byte> SpiBus::execute(std::uint32_t command)
 
             if (retries < 255)
             {
+                m_syncRetries++;
                 co_await m_spi.xmit({}, buffer);
             }
         }
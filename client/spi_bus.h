@@ -12,11 +12,17 @@ class SpiBus : public BasicBus
 public:
     explicit SpiBus(Spi& spi) noexcept;
 
+    constexpr std::uint64_t syncRetries() const noexcept
+    {
+        return m_syncRetries;
+    }
+
 protected:
     asio::awaitable<std::byte> execute(std::uint32_t command) override;
 
 private:
     Spi& m_spi;
+    std::uint64_t m_syncRetries = 0;
 };
 
 } // namespace tt09_levenshtein
\ No newline at end of file
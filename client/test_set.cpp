@@ -1,9 +1,12 @@
 #include "test_set.h"
 
+#include "unicode.h"
+
 #include <fmt/format.h>
 
-#include <random>
-#include <set>
+#include <algorithm>
+#include <cmath>
+#include <map>
 #include <stdexcept>
 #include <utility>
 
@@ -11,41 +14,101 @@ namespace tt09_levenshtein
 {
 
 TestSet::TestSet(const Config& config)
+    : m_prng(config.seed)
 {
-    std::set<std::string> words;
-
-    m_dictionaryWords = generateWords(
-        config.minChar,
-        config.maxChar,
-        config.minDictionaryWordLength,
-        config.maxDictionaryWordLength,
-        config.dictionaryWordCount,
-        words);
-
-    m_searchWords = generateWords(
-        config.minChar,
-        config.maxChar,
-        config.minSearchWordLength,
-        config.maxSearchWordLength,
-        config.searchWordCount,
-        words);
+    createAlphabet(config);
+
+    std::unordered_set<std::string> words;
+    words.reserve(config.dictionaryWordCount + (config.searchEdits == 0 ? config.searchWordCount : 0));
+
+    m_dictionaryWords = generateWords({config.minDictionaryWordLength, config.maxDictionaryWordLength}, config.dictionaryWordCount, words);
+
+    if (config.searchEdits == 0)
+    {
+        m_searchWords = generateWords({config.minSearchWordLength, config.maxSearchWordLength}, config.searchWordCount, words);
+    }
+    else
+    {
+        m_searchWords = generateEdits({config.minSearchWordLength, config.maxSearchWordLength}, config.searchWordCount, config.searchEdits);
+    }
 }
 
-std::vector<std::string> TestSet::generateWords(
-    char minChar,
-    char maxChar,
-    unsigned int minLength,
-    unsigned int maxLength,
-    unsigned int count,
-    std::set<std::string>& words)
+void TestSet::createAlphabet(const Config& config)
 {
-    const unsigned int maxRetries = 10;
+    std::vector<double> charWeights;
+
+    if (config.corpus.empty())
+    {
+        for (auto c = static_cast<unsigned char>(config.minChar); c <= static_cast<unsigned char>(config.maxChar); ++c)
+        {
+            m_alphabet.push_back(c);
+            charWeights.push_back(1.0 / std::pow(static_cast<double>(m_alphabet.size()), config.charSkew));
+        }
+    }
+    else
+    {
+        std::map<char32_t, std::uint64_t> charCounts;
+        for (const auto& word : config.corpus)
+        {
+            auto decoded = Unicode::toUTF32(word);
+            for (auto c : decoded)
+            {
+                charCounts[c]++;
+            }
+            if (m_lengthWeights.size() <= decoded.size())
+            {
+                m_lengthWeights.resize(decoded.size() + 1);
+            }
+            m_lengthWeights[decoded.size()]++;
+        }
+        for (auto [c, count] : charCounts)
+        {
+            m_alphabet.push_back(c);
+            charWeights.push_back(static_cast<double>(count));
+        }
+    }
+
+    if (m_alphabet.empty())
+    {
+        throw std::invalid_argument("Test alphabet is empty");
+    }
+
+    // Characters are encoded once, so that words can be assembled by concatenation
+    for (auto c : m_alphabet)
+    {
+        m_encodedAlphabet.push_back(Unicode::toUTF8(std::u32string_view(&c, 1)));
+    }
+    m_charDist = std::discrete_distribution<std::size_t>(charWeights.begin(), charWeights.end());
+}
+
+std::discrete_distribution<unsigned int> TestSet::lengthDistribution(LengthRange range) const
+{
+    if (range.min > range.max)
+    {
+        throw std::invalid_argument(fmt::format("Invalid word length range {}-{}", range.min, range.max));
+    }
+
+    // Corpus lengths outside the range are dropped. Without any left, lengths are uniformly distributed
+    std::vector<double> weights(range.max - range.min + 1, 0.0);
+    double total = 0.0;
+    for (auto length = range.min; length <= range.max && length < m_lengthWeights.size(); ++length)
+    {
+        weights[length - range.min] = m_lengthWeights[length];
+        total += m_lengthWeights[length];
+    }
+    if (total == 0.0)
+    {
+        std::fill(weights.begin(), weights.end(), 1.0);
+    }
+
+    return std::discrete_distribution<unsigned int>(weights.begin(), weights.end());
+}
 
-    std::random_device rng;
-    std::default_random_engine prng(rng());
+std::vector<std::string> TestSet::generateWords(LengthRange range, unsigned int count, std::unordered_set<std::string>& words)
+{
+    const unsigned int maxRetries = 10;
 
-    std::uniform_int_distribution<unsigned int> lengthDist(minLength, maxLength);
-    std::uniform_int_distribution<char> charDist(minChar, maxChar);
+    auto lengthDist = lengthDistribution(range);
 
     std::vector<std::string> wordList;
     wordList.reserve(count);
@@ -58,15 +121,13 @@ std::vector<std::string> TestSet::generateWords(
         for (retries = 0; retries != maxRetries; ++retries)
         {
             word.clear();
-            auto length = lengthDist(prng);
-            word.reserve(length);
-
-            for (std::string::size_type j = 0; j != length; ++j)
+            auto length = range.min + lengthDist(m_prng);
+            for (unsigned int j = 0; j != length; ++j)
             {
-                word.push_back(charDist(prng));
+                word.append(m_encodedAlphabet[m_charDist(m_prng)]);
             }
 
-            if (!words.contains(word))
+            if (words.insert(word).second)
             {
                 break;
             }
@@ -77,12 +138,73 @@ std::vector<std::string> TestSet::generateWords(
             throw std::runtime_error(fmt::format("Failed to generate a unique word after {} retries", maxRetries).c_str());
         }
 
-        words.insert(word);
         wordList.push_back(std::move(word));
     }
 
     return wordList;
 }
 
-} // namespace tt09_levenshtein
+std::vector<std::string> TestSet::generateEdits(LengthRange range, unsigned int count, unsigned int edits)
+{
+    const unsigned int maxRetries = 100;
+
+    if (m_dictionaryWords.empty())
+    {
+        throw std::invalid_argument("Cannot derive search words from an empty dictionary");
+    }
+
+    std::uniform_int_distribution<std::size_t> wordDist(0, m_dictionaryWords.size() - 1);
+    std::uniform_int_distribution<unsigned int> editDist(0, 2);
+
+    std::vector<std::string> wordList;
+    wordList.reserve(count);
 
+    for (unsigned int i = 0; i != count; ++i)
+    {
+        std::u32string word;
+
+        unsigned int retries;
+        for (retries = 0; retries != maxRetries; ++retries)
+        {
+            word = Unicode::toUTF32(m_dictionaryWords[wordDist(m_prng)]);
+            for (unsigned int j = 0; j != edits; ++j)
+            {
+                auto edit = word.empty() ? 0 : editDist(m_prng);
+                auto position = std::uniform_int_distribution<std::size_t>(0, edit == 0 ? word.size() : word.size() - 1)(m_prng);
+                auto c = m_alphabet[m_charDist(m_prng)];
+                while (edit == 2 && c == word[position] && m_alphabet.size() > 1)
+                {
+                    c = m_alphabet[m_charDist(m_prng)];
+                }
+                if (edit == 0)
+                {
+                    word.insert(position, 1, c);
+                }
+                else if (edit == 1)
+                {
+                    word.erase(position, 1);
+                }
+                else
+                {
+                    word[position] = c;
+                }
+            }
+
+            if (word.size() >= range.min && word.size() <= range.max)
+            {
+                break;
+            }
+        }
+
+        if (retries == maxRetries)
+        {
+            throw std::runtime_error(fmt::format("Failed to generate a search word of {}-{} characters after {} retries", range.min, range.max, maxRetries).c_str());
+        }
+
+        wordList.push_back(Unicode::toUTF8(word));
+    }
+
+    return wordList;
+}
+
+} // namespace tt09_levenshtein
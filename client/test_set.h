@@ -1,26 +1,39 @@
 #pragma once
 
-#include <set>
+#include <cstdint>
+#include <random>
 #include <span>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 namespace tt09_levenshtein
 {
 
+// Reproducible dictionary and search words for benchmarks and regression tests
+//
+// The same seed and configuration always produce the same words.
 class TestSet
 {
 public:
     struct Config
     {
+        std::uint64_t seed = 0;
         char minChar = 0;
         char maxChar = 0;
+        // Zipf exponent of the character distribution, ranked from minChar. 0 gives uniformly distributed characters
+        double charSkew = 0.0;
+        // When not empty, characters and word lengths are drawn with the frequencies found in these words instead
+        std::span<const std::string> corpus;
         unsigned int minDictionaryWordLength = 0;
         unsigned int maxDictionaryWordLength = 0;
         unsigned int dictionaryWordCount = 0;
         unsigned int minSearchWordLength = 0;
         unsigned int maxSearchWordLength = 0;
         unsigned int searchWordCount = 0;
+        // When not 0, each search word is a dictionary word with this many random insertions, deletions and
+        // substitutions, rather than a word which is not in the dictionary
+        unsigned int searchEdits = 0;
     };
 
     explicit TestSet(const Config& config);
@@ -36,16 +49,24 @@ public:
     }
 
 private:
-    static std::vector<std::string> generateWords(
-        char minChar,
-        char maxChar,
-        unsigned int minLength,
-        unsigned int maxLength,
-        unsigned int count,
-        std::set<std::string>& words);
+    struct LengthRange
+    {
+        unsigned int min;
+        unsigned int max;
+    };
+
+    void createAlphabet(const Config& config);
+    std::discrete_distribution<unsigned int> lengthDistribution(LengthRange range) const;
+    std::vector<std::string> generateWords(LengthRange range, unsigned int count, std::unordered_set<std::string>& words);
+    std::vector<std::string> generateEdits(LengthRange range, unsigned int count, unsigned int edits);
 
+    std::mt19937_64 m_prng;
+    std::vector<char32_t> m_alphabet;
+    std::vector<std::string> m_encodedAlphabet;
+    std::discrete_distribution<std::size_t> m_charDist;
+    std::vector<double> m_lengthWeights;
     std::vector<std::string> m_dictionaryWords;
     std::vector<std::string> m_searchWords;
 };
 
-} // namespace tt09_levenshtein
\ No newline at end of file
+} // namespace tt09_levenshtein
@@ -1,6 +1,11 @@
 `default_nettype none
 
 module top
+    #(
+        parameter integer SHARED_BUS = 0,
+        // More than one engine disables front coding, which needs the prefix stack of a single engine
+        parameter integer NUM_ENGINES = 1
+    )
     (
         input wire clk,
         input wire rst_n,
@@ -37,7 +42,16 @@ module top
     assign ui_in[6] = spi_mosi;
     assign spi_miso = uo_out[7];
 
-    tt_um_pchri03_levenshtein levenshtein(
+    tt_um_pchri03_levenshtein #(
+        .PREFIX_STACK_DEPTH(16),
+        .VECTOR_CACHE_SIZE(16),
+        .DICT_PREFETCH(1),
+        .NUM_ENGINES(NUM_ENGINES),
+        .FILL_DMA(1),
+        .SHARED_BUS(SHARED_BUS),
+        // 384 cycles is 7.68 us at 50 MHz, within the 8 us tCEM of common PSRAMs
+        .SPI_MAX_SELECT_CYCLES(384)
+    ) levenshtein(
         .clk(clk),
         .rst_n(rst_n),
         .ena(ena),
@@ -0,0 +1,199 @@
+#include "tracer.h"
+
+#include "context.h"
+
+#include <fmt/format.h>
+
+#include <bit>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_set>
+
+namespace tt09_levenshtein
+{
+
+namespace
+{
+
+thread_local std::uint64_t t_generation = 0;
+thread_local void* t_buffer = nullptr;
+
+std::string escape(std::string_view string)
+{
+    std::string buffer;
+    buffer.reserve(string.size());
+    for (auto c : string)
+    {
+        if (c == '"' || c == '\\')
+        {
+            buffer.push_back('\\');
+        }
+        buffer.push_back(c);
+    }
+    return buffer;
+}
+
+} // namespace
+
+std::atomic<Tracer*> Tracer::s_current = nullptr;
+std::atomic<std::uint64_t> Tracer::s_generation = 0;
+
+Tracer::Tracer(const Context& context, std::size_t capacity)
+    : m_context(context)
+    , m_capacity(std::bit_ceil(capacity))
+    , m_generation(++s_generation)
+{
+    Tracer* expected = nullptr;
+    if (!s_current.compare_exchange_strong(expected, this, std::memory_order_acq_rel))
+    {
+        throw std::logic_error("Another tracer is already installed");
+    }
+}
+
+Tracer::~Tracer()
+{
+    s_current.store(nullptr, std::memory_order_release);
+}
+
+void Tracer::begin(const char* category, const char* name) noexcept
+{
+    record(category, name, 'B');
+}
+
+void Tracer::end(const char* category, const char* name) noexcept
+{
+    record(category, name, 'E');
+}
+
+std::uint64_t Tracer::beginAsync(const char* category, const char* name) noexcept
+{
+    auto id = m_nextId.fetch_add(1, std::memory_order_relaxed);
+    record(category, name, 'b', id);
+    return id;
+}
+
+void Tracer::endAsync(const char* category, const char* name, std::uint64_t id) noexcept
+{
+    record(category, name, 'e', id);
+}
+
+void Tracer::record(const char* category, const char* name, char phase, std::uint64_t id) noexcept
+{
+    Buffer* buffer;
+    try
+    {
+        buffer = this->buffer();
+    }
+    catch (...)
+    {
+        return;
+    }
+
+    auto head = buffer->head.load(std::memory_order_relaxed);
+    buffer->events[head & (m_capacity - 1)] = Event{category, name, m_context.now().count(), id, phase};
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+Tracer::Buffer* Tracer::buffer()
+{
+    if (t_generation != m_generation)
+    {
+        auto buffer = std::make_unique<Buffer>();
+        buffer->events.resize(m_capacity);
+
+        std::lock_guard lock(m_buffersMutex);
+        buffer->threadId = static_cast<std::uint32_t>(m_buffers.size() + 1);
+        t_buffer = buffer.get();
+        t_generation = m_generation;
+        m_buffers.push_back(std::move(buffer));
+    }
+    return static_cast<Buffer*>(t_buffer);
+}
+
+void Tracer::write(const std::filesystem::path& path) const
+{
+    std::ofstream stream(path.string().c_str());
+    if (!stream.good())
+    {
+        throw std::runtime_error(fmt::format("Error creating trace file: {}", path.string()));
+    }
+
+    stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"client\"}}";
+
+    std::lock_guard lock(m_buffersMutex);
+
+    // A coroutine can resume on another thread, so async events are matched across all buffers
+    std::unordered_set<std::uint64_t> asyncBegins;
+    for (const auto& buffer : m_buffers)
+    {
+        auto head = buffer->head.load(std::memory_order_acquire);
+        auto tail = head > m_capacity ? head - m_capacity : 0;
+        for (auto i = tail; i != head; ++i)
+        {
+            const auto& event = buffer->events[i & (m_capacity - 1)];
+            if (event.phase == 'b')
+            {
+                asyncBegins.insert(event.id);
+            }
+        }
+    }
+
+    for (const auto& buffer : m_buffers)
+    {
+        auto head = buffer->head.load(std::memory_order_acquire);
+        auto tail = head > m_capacity ? head - m_capacity : 0;
+
+        // Events may have been overwritten, so skip end events whose begin event is gone
+        unsigned int depth = 0;
+        for (auto i = tail; i != head; ++i)
+        {
+            const auto& event = buffer->events[i & (m_capacity - 1)];
+            if (event.phase == 'b' || event.phase == 'e')
+            {
+                if (!asyncBegins.contains(event.id))
+                {
+                    continue;
+                }
+
+                stream << fmt::format(
+                    ",\n{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"{}\",\"id\":{},\"ts\":{}.{:03},\"pid\":1,\"tid\":{}}}",
+                    escape(event.name),
+                    escape(event.category),
+                    event.phase,
+                    event.id,
+                    event.timestamp / 1000,
+                    event.timestamp % 1000,
+                    buffer->threadId);
+                continue;
+            }
+
+            if (event.phase == 'B')
+            {
+                depth++;
+            }
+            else if (depth == 0)
+            {
+                continue;
+            }
+            else
+            {
+                depth--;
+            }
+
+            stream << fmt::format(
+                ",\n{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"{}\",\"ts\":{}.{:03},\"pid\":1,\"tid\":{}}}",
+                escape(event.name),
+                escape(event.category),
+                event.phase,
+                event.timestamp / 1000,
+                event.timestamp % 1000,
+                buffer->threadId);
+        }
+    }
+
+    stream << "\n]}\n";
+}
+
+} // namespace tt09_levenshtein
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tt09_levenshtein
+{
+
+class Context;
+
+// Records begin/end events into per-thread ring buffers and writes them as a Chrome trace-event file
+//
+// Scopes in coroutines are recorded as async events with an id of their own, since other coroutines run on the same
+// thread while they are suspended and would otherwise appear nested inside them.
+//
+// Only one tracer can be installed at a time. Recording is wait-free: each thread owns its buffer and only
+// publishes the write index, so the writer never blocks on readers or other threads. The buffers are only read
+// once tracing has stopped.
+class Tracer
+{
+public:
+    explicit Tracer(const Context& context, std::size_t capacity = 1 << 20);
+    Tracer(const Tracer&) = delete;
+    ~Tracer();
+
+    Tracer& operator=(const Tracer&) = delete;
+
+    static Tracer* current() noexcept
+    {
+        return s_current.load(std::memory_order_acquire);
+    }
+
+    void begin(const char* category, const char* name) noexcept;
+    void end(const char* category, const char* name) noexcept;
+    std::uint64_t beginAsync(const char* category, const char* name) noexcept;
+    void endAsync(const char* category, const char* name, std::uint64_t id) noexcept;
+
+    void write(const std::filesystem::path& path) const;
+
+private:
+    struct Event
+    {
+        const char* category;
+        const char* name;
+        std::int64_t timestamp;
+        std::uint64_t id;
+        char phase;
+    };
+
+    struct Buffer
+    {
+        std::vector<Event> events;
+        std::atomic<std::uint64_t> head = 0;
+        std::uint32_t threadId = 0;
+    };
+
+    void record(const char* category, const char* name, char phase, std::uint64_t id = 0) noexcept;
+    Buffer* buffer();
+
+    const Context& m_context;
+    std::size_t m_capacity;
+    std::uint64_t m_generation;
+    std::atomic<std::uint64_t> m_nextId = 1;
+    mutable std::mutex m_buffersMutex;
+    std::vector<std::unique_ptr<Buffer>> m_buffers;
+
+    static std::atomic<Tracer*> s_current;
+    static std::atomic<std::uint64_t> s_generation;
+};
+
+class TraceScope
+{
+public:
+    TraceScope(const char* category, const char* name) noexcept
+        : m_tracer(Tracer::current())
+        , m_category(category)
+        , m_name(name)
+    {
+        if (m_tracer)
+        {
+            m_tracer->begin(m_category, m_name);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+
+    ~TraceScope()
+    {
+        // The tracer may be gone if a suspended coroutine is destroyed after tracing has stopped
+        if (m_tracer && m_tracer == Tracer::current())
+        {
+            m_tracer->end(m_category, m_name);
+        }
+    }
+
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    Tracer* m_tracer;
+    const char* m_category;
+    const char* m_name;
+};
+
+// Scope for coroutines, which may be suspended while other scopes begin and end on the same thread
+class AsyncTraceScope
+{
+public:
+    AsyncTraceScope(const char* category, const char* name) noexcept
+        : m_tracer(Tracer::current())
+        , m_category(category)
+        , m_name(name)
+    {
+        if (m_tracer)
+        {
+            m_id = m_tracer->beginAsync(m_category, m_name);
+        }
+    }
+
+    AsyncTraceScope(const AsyncTraceScope&) = delete;
+
+    ~AsyncTraceScope()
+    {
+        // The tracer may be gone if a suspended coroutine is destroyed after tracing has stopped
+        if (m_tracer && m_tracer == Tracer::current())
+        {
+            m_tracer->endAsync(m_category, m_name, m_id);
+        }
+    }
+
+    AsyncTraceScope& operator=(const AsyncTraceScope&) = delete;
+
+private:
+    Tracer* m_tracer;
+    const char* m_category;
+    const char* m_name;
+    std::uint64_t m_id = 0;
+};
+
+} // namespace tt09_levenshtein
@@ -21,5 +21,13 @@ std::u32string Unicode::toUTF32(std::string_view string)
     return buffer;
 }
 
+std::string Unicode::toUTF8(std::u32string_view word)
+{
+    auto unicodeString = icu::UnicodeString::fromUTF32(reinterpret_cast<const UChar32*>(word.data()), static_cast<std::int32_t>(word.size()));
+    std::string buffer;
+    unicodeString.toUTF8String(buffer);
+
+    return buffer;
+}
 
 } // namespace tt09_levenshtein
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
 namespace tt09_levenshtein
 {
@@ -9,6 +10,7 @@ class Unicode
 {
 public:
     static std::u32string toUTF32(std::string_view word);
+    static std::string toUTF8(std::u32string_view word);
 };
 
 } // namespace tt09_levenshtein
\ No newline at end of file
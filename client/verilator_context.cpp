@@ -1,42 +1,66 @@
 #include "verilator_context.h"
 
+#include "tracer.h"
+
 #include <asio/co_spawn.hpp>
 #include <asio/detached.hpp>
 #include <asio/post.hpp>
+#include <asio/redirect_error.hpp>
+#include <asio/this_coro.hpp>
 #include <asio/use_awaitable.hpp>
 #include <verilated.h>
-#include <verilated_vcd_c.h>
+#include <verilated_fst_c.h>
+#include <verilated_save.h>
+
+#include <stdexcept>
 
 namespace tt09_levenshtein
 {
 
 VerilatorContext::VerilatorContext(unsigned long int frequency)
-    : m_halfPeriod(2000000000UL / frequency)
+    : m_halfPeriod(500000000UL / frequency)
 {
+    m_verilatedContext.timeunit(9);
+    m_verilatedContext.timeprecision(9);
 }
 
-VerilatorContext::VerilatorContext(unsigned long int frequency, const std::filesystem::path& vcdFileName)
-    : m_halfPeriod(2000000000UL / frequency)
+VerilatorContext::VerilatorContext(unsigned long int frequency, const TraceConfig& traceConfig)
+    : VerilatorContext(frequency)
 {
+    m_traceConfig = traceConfig;
+    m_traceGate = !traceConfig.gated;
+
     Verilated::traceEverOn(true);
 
-    m_vcd = std::make_unique<VerilatedVcdC>();
-    m_top.trace(m_vcd.get(), 99);
+    m_trace = std::make_unique<VerilatedFstC>();
+    if (!traceConfig.scope.empty())
+    {
+        m_trace->dumpvars(traceConfig.depth, traceConfig.scope);
+    }
+    m_top.trace(m_trace.get(), traceConfig.depth);
 
-    m_vcd->open(vcdFileName.string().c_str());
+    m_trace->open(traceConfig.path.string().c_str());
 }
 
 asio::awaitable<void> VerilatorContext::clock()
 {
-    co_await risingEdge(m_top.clk);
+    co_await clocks(1);
 }
 
 asio::awaitable<void> VerilatorContext::clocks(unsigned int count)
 {
-    for (unsigned int i = 0; i != count; i++)
+    if (count == 0)
     {
-        co_await clock();
+        co_return;
     }
+
+    co_await asio::async_initiate<decltype(asio::use_awaitable), void()>(
+        [this, count](auto handler)
+        {
+            m_timers.emplace(m_cycles + count, std::move(handler));
+            wake();
+        },
+        asio::use_awaitable);
 }
 
 asio::awaitable<void> VerilatorContext::init()
@@ -55,34 +79,156 @@ asio::awaitable<void> VerilatorContext::init()
     co_await clocks(10);
 }
 
+void VerilatorContext::save(const std::filesystem::path& path)
+{
+    if (!m_timers.empty() || !m_watchers.empty())
+    {
+        throw std::logic_error("Cannot save state while waiting on the simulation");
+    }
+
+    VerilatedSave os;
+    os.open(path.string().c_str());
+    if (!os.isOpen())
+    {
+        throw std::runtime_error("Error opening " + path.string());
+    }
+
+    std::uint64_t time = m_time.count();
+    os << time << m_cycles << m_top;
+    os.close();
+}
+
+asio::awaitable<void> VerilatorContext::restore(const std::filesystem::path& path)
+{
+    auto executor = co_await asio::this_coro::executor;
+
+    VerilatedRestore is;
+    is.open(path.string().c_str());
+    if (!is.isOpen())
+    {
+        throw std::runtime_error("Error opening " + path.string());
+    }
+
+    std::uint64_t time = 0;
+    is >> time >> m_cycles >> m_top;
+    is.close();
+
+    m_time = std::chrono::nanoseconds(time);
+    m_verilatedContext.time(time);
+
+    asio::co_spawn(executor, runClock(), asio::detached);
+}
+
 asio::awaitable<void> VerilatorContext::wait(std::chrono::nanoseconds time)
 {
+    AsyncTraceScope scope("context", "wait");
     co_await clocks(time.count() / (m_halfPeriod.count() * 2));
 }
 
+void VerilatorContext::setTraceGate(bool open) noexcept
+{
+    m_traceGate = open;
+}
+
+std::chrono::nanoseconds VerilatorContext::now() const noexcept
+{
+    return m_time;
+}
+
 asio::awaitable<void> VerilatorContext::runClock()
 {
     auto executor = co_await asio::this_coro::executor;
 
-    VerilatedContext context;
-    context.timeunit(9);
-    context.timeprecision(9);
+    m_executor.emplace(executor);
+    m_idleTimer.emplace(executor);
 
     while (true)
     {
-        context.timeInc(m_halfPeriod.count());
-        m_time += m_halfPeriod;
-
-        m_top.clk ^= 1;
-        m_top.eval();
+        if (m_timers.empty() && m_watchers.empty())
+        {
+            asio::error_code ec;
+            m_idleTimer->expires_at(asio::steady_timer::time_point::max());
+            co_await m_idleTimer->async_wait(asio::redirect_error(asio::use_awaitable, ec));
+            continue;
+        }
 
-        if (m_vcd)
+        while (!step())
         {
-            m_vcd->dump(context.time());
         }
 
+        // Let the resumed coroutines run until they wait on the simulation again
         co_await asio::post(executor, asio::use_awaitable);
     }
 }
 
+bool VerilatorContext::step()
+{
+    m_verilatedContext.timeInc(m_halfPeriod.count());
+    m_time += m_halfPeriod;
+
+    m_top.clk ^= 1;
+    m_top.eval();
+
+    if (m_trace)
+    {
+        dump();
+    }
+
+    bool resumed = false;
+
+    if (m_top.clk)
+    {
+        m_cycles++;
+        while (!m_timers.empty() && m_timers.begin()->first <= m_cycles)
+        {
+            resume(std::move(m_timers.extract(m_timers.begin()).mapped()));
+            resumed = true;
+        }
+    }
+
+    for (auto it = m_watchers.begin(); it != m_watchers.end();)
+    {
+        if (it->predicate())
+        {
+            resume(std::move(it->handler));
+            it = m_watchers.erase(it);
+            resumed = true;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    return resumed;
+}
+
+void VerilatorContext::resume(Handler handler)
+{
+    asio::post(*m_executor, std::move(handler));
+}
+
+void VerilatorContext::wake()
+{
+    if (m_idleTimer)
+    {
+        m_idleTimer->cancel();
+    }
+}
+
+void VerilatorContext::dump()
+{
+    if (m_time >= m_traceConfig.stopTime || m_cycles >= m_traceConfig.stopCycle)
+    {
+        m_trace->close();
+        m_trace.reset();
+        return;
+    }
+
+    if (m_traceGate && m_time >= m_traceConfig.startTime && m_cycles >= m_traceConfig.startCycle)
+    {
+        m_trace->dump(m_verilatedContext.time());
+    }
+}
+
 } // namespace tt09_levenshtein
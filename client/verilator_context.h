@@ -3,60 +3,98 @@
 #include "context.h"
 #include "Vtop.h"
 
+#include <asio/any_completion_handler.hpp>
+#include <asio/any_io_executor.hpp>
+#include <asio/async_result.hpp>
 #include <asio/awaitable.hpp>
-#include <asio/post.hpp>
-#include <asio/this_coro.hpp>
+#include <asio/steady_timer.hpp>
 #include <asio/use_awaitable.hpp>
-#include <verilated_vcd_c.h>
+#include <verilated.h>
+#include <verilated_fst_c.h>
 
 #include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
 #include <memory>
 #include <filesystem>
 #include <optional>
+#include <string>
+#include <vector>
 
 namespace tt09_levenshtein
 {
 
+// Simulation context driving a Verilator model
+//
+// The clock is advanced in a tight loop by a single kernel coroutine. Coroutines waiting on the simulation register
+// either a cycle number or a predicate, and are only resumed once their condition has become true. When nothing is
+// waiting, the kernel parks instead of advancing the model.
 class VerilatorContext : public Context
 {
 public:
+    // FST waveform tracing restricted to a window of the simulation
+    //
+    // A step is dumped only when it lies within both the time and the cycle window and the trace gate is open. Once
+    // either window has been left, the trace file is closed and tracing stops for the remainder of the run.
+    struct TraceConfig
+    {
+        std::filesystem::path path;
+        // Hierarchy prefix to dump, e.g. TOP.top.levenshtein. Empty dumps the whole model
+        std::string scope;
+        int depth = 99;
+        std::chrono::nanoseconds startTime = {};
+        std::chrono::nanoseconds stopTime = std::chrono::nanoseconds::max();
+        std::uint64_t startCycle = 0;
+        std::uint64_t stopCycle = std::numeric_limits<std::uint64_t>::max();
+        // When set, nothing is dumped until the gate is opened with setTraceGate()
+        bool gated = false;
+    };
+
     explicit VerilatorContext(unsigned long int frequency);
-    VerilatorContext(unsigned long int frequency, const std::filesystem::path& vcdFileName);
+    VerilatorContext(unsigned long int frequency, const TraceConfig& traceConfig);
+
+    // Completes once predicate returns true. The predicate is evaluated after every evaluation of the model
+    template<typename Predicate, typename CompletionToken>
+    auto asyncWaitUntil(Predicate predicate, CompletionToken&& token)
+    {
+        return asio::async_initiate<CompletionToken, void()>(
+            [this](auto handler, Predicate predicate)
+            {
+                m_watchers.push_back(Watcher{std::move(predicate), std::move(handler)});
+                wake();
+            },
+            token,
+            std::move(predicate));
+    }
 
     template<typename T, typename V = int>
     asio::awaitable<void> fallingEdge(T& pin, V mask = 1)
     {
-        auto executor = co_await asio::this_coro::executor;
-
-        auto oldValue = pin & mask;
-        while (true)
-        {
-            co_await asio::post(executor, asio::use_awaitable);
-            auto newValue = pin & mask;
-            if (oldValue && !newValue)
+        co_await asyncWaitUntil(
+            [&pin, mask, oldValue = pin & mask]() mutable
             {
-                break;
-            }
-            oldValue = newValue;
-        }
+                auto newValue = pin & mask;
+                bool edge = oldValue && !newValue;
+                oldValue = newValue;
+                return edge;
+            },
+            asio::use_awaitable);
     }
 
     template<typename T, typename V = int>
     asio::awaitable<void> risingEdge(T& pin, V mask = 1)
     {
-        auto executor = co_await asio::this_coro::executor;
-
-        auto oldValue = pin & mask;
-        while (true)
-        {
-            co_await asio::post(executor, asio::use_awaitable);
-            auto newValue = pin & mask;
-            if (!oldValue && newValue)
+        co_await asyncWaitUntil(
+            [&pin, mask, oldValue = pin & mask]() mutable
             {
-                break;
-            }
-            oldValue = newValue;
-        }
+                auto newValue = pin & mask;
+                bool edge = !oldValue && newValue;
+                oldValue = newValue;
+                return edge;
+            },
+            asio::use_awaitable);
     }
 
     asio::awaitable<void> clock();
@@ -64,7 +102,22 @@ public:
     asio::awaitable<void> clocks(unsigned int count);
 
     asio::awaitable<void> init() override;
+
+    // Snapshot of the model, including SRAM contents, and of simulated time. Only valid while nothing waits on the
+    // simulation, and only restorable into the same build of the model
+    void save(const std::filesystem::path& path);
+
+    // Starts the simulation from a snapshot instead of resetting the model
+    asio::awaitable<void> restore(const std::filesystem::path& path);
     asio::awaitable<void> wait(std::chrono::nanoseconds time) override;
+    std::chrono::nanoseconds now() const noexcept override;
+
+    void setTraceGate(bool open) noexcept;
+
+    constexpr std::uint64_t cycles() const noexcept
+    {
+        return m_cycles;
+    }
 
     constexpr Vtop& top() noexcept
     {
@@ -77,11 +130,31 @@ public:
     }
 
 private:
+    using Handler = asio::any_completion_handler<void()>;
+
+    struct Watcher
+    {
+        std::function<bool()> predicate;
+        Handler handler;
+    };
+
     asio::awaitable<void> runClock();
-    
+    bool step();
+    void resume(Handler handler);
+    void wake();
+    void dump();
+
     std::chrono::nanoseconds m_halfPeriod;
     std::chrono::nanoseconds m_time = {};
-    std::unique_ptr<VerilatedVcdC> m_vcd;
+    std::uint64_t m_cycles = 0;
+    std::multimap<std::uint64_t, Handler> m_timers;
+    std::vector<Watcher> m_watchers;
+    std::optional<asio::any_io_executor> m_executor;
+    std::optional<asio::steady_timer> m_idleTimer;
+    VerilatedContext m_verilatedContext;
+    std::unique_ptr<VerilatedFstC> m_trace;
+    TraceConfig m_traceConfig;
+    bool m_traceGate = true;
     Vtop m_top;
 };
 
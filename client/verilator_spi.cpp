@@ -1,8 +1,8 @@
 #include "verilator_spi.h"
 
+#include "tracer.h"
 #include "verilator_context.h"
 
-#include <cstdint>
 #include <stdexcept>
 
 namespace tt09_levenshtein
@@ -11,6 +11,7 @@ namespace tt09_levenshtein
 VerilatorSpi::VerilatorSpi(VerilatorContext& context, unsigned int clockDivider) noexcept
     : m_context(context)
     , m_clockDivider(clockDivider)
+    , m_transactor(context, clockDivider)
 {
     m_context.top().spi_ss_n = 1;
 }
@@ -29,49 +30,19 @@ asio::awaitable<void> VerilatorSpi::disable()
 
 asio::awaitable<void> VerilatorSpi::xmit(std::span<const std::byte> data, std::span<std::byte> buffer)
 {
+    AsyncTraceScope scope("spi", "xmit");
+
     if (m_context.top().spi_ss_n)
     {
         throw std::logic_error("Transfer not allowed when SPI is disabled");
     }
 
-    auto lowClocks = m_clockDivider / 2;
-    auto highClocks = m_clockDivider - lowClocks;
-
-    auto& sck = m_context.top().spi_sck;
-    auto& mosi = m_context.top().spi_mosi;
-    const auto& miso = m_context.top().spi_miso;
-
-    for (auto b : data)
+    if (data.empty() && buffer.empty())
     {
-        auto valueOut = std::to_integer<std::uint8_t>(b);
-
-        for (unsigned int i = 0; i != 8; ++i)
-        {
-            sck = 0;
-            mosi = valueOut >> 7;
-            valueOut <<= 1;
-            co_await m_context.clocks(lowClocks);
-            
-            sck = 1;
-            co_await m_context.clocks(highClocks);
-        }
+        co_return;
     }
 
-    for (auto& b : buffer)
-    {
-        std::uint8_t valueIn = 0;
-        for (unsigned int i = 0; i != 8; ++i)
-        {
-            sck = 0;
-            co_await m_context.clocks(lowClocks);
-            
-            valueIn = (valueIn << 1) | (miso ? 1 : 0);
-            sck = 1;
-            co_await m_context.clocks(highClocks);
-        }
-
-        b = std::byte(valueIn);
-    }
+    co_await m_transactor.asyncTransfer(data, buffer, asio::use_awaitable);
 }
 
 } // namespace tt09_levenshtein
\ No newline at end of file
@@ -1,12 +1,11 @@
 #pragma once
 
 #include "spi.h"
+#include "verilator_spi_transactor.h"
 
 namespace tt09_levenshtein
 {
 
-class VerilatorContext;
-
 class VerilatorSpi : public Spi
 {
 public:
@@ -19,6 +18,7 @@ public:
 private:
     VerilatorContext& m_context;
     unsigned int m_clockDivider;
+    VerilatorSpiTransactor m_transactor;
 };
 
 } // namespace tt09_levenshtein
\ No newline at end of file
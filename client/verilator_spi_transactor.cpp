@@ -0,0 +1,81 @@
+#include "verilator_spi_transactor.h"
+
+#include <algorithm>
+
+namespace tt09_levenshtein
+{
+
+VerilatorSpiTransactor::VerilatorSpiTransactor(VerilatorContext& context, unsigned int clockDivider) noexcept
+    : m_context(context)
+    , m_lowClocks(std::max(1U, clockDivider / 2))
+    , m_highClocks(std::max(1U, clockDivider - clockDivider / 2))
+{
+}
+
+void VerilatorSpiTransactor::start(std::span<const std::byte> data, std::span<std::byte> buffer) noexcept
+{
+    m_data = data;
+    m_buffer = buffer;
+    m_bit = 0;
+    m_bitCount = (data.size() + buffer.size()) * 8;
+    m_valueIn = 0;
+
+    beginBit();
+}
+
+void VerilatorSpiTransactor::beginBit() noexcept
+{
+    auto& top = m_context.top();
+
+    top.spi_sck = 0;
+    if (m_bit < m_data.size() * 8)
+    {
+        auto value = std::to_integer<std::uint8_t>(m_data[m_bit / 8]);
+        top.spi_mosi = (value >> (7 - m_bit % 8)) & 1;
+    }
+
+    m_phase = Phase::Low;
+    m_countdown = m_lowClocks;
+}
+
+bool VerilatorSpiTransactor::clock() noexcept
+{
+    auto& top = m_context.top();
+
+    if (!top.clk || m_bit == m_bitCount)
+    {
+        return m_bit == m_bitCount;
+    }
+
+    if (--m_countdown != 0)
+    {
+        return false;
+    }
+
+    if (m_phase == Phase::Low)
+    {
+        if (m_bit >= m_data.size() * 8)
+        {
+            m_valueIn = (m_valueIn << 1) | (top.spi_miso ? 1 : 0);
+            if (m_bit % 8 == 7)
+            {
+                m_buffer[m_bit / 8 - m_data.size()] = std::byte(m_valueIn);
+            }
+        }
+
+        top.spi_sck = 1;
+        m_phase = Phase::High;
+        m_countdown = m_highClocks;
+        return false;
+    }
+
+    if (++m_bit == m_bitCount)
+    {
+        return true;
+    }
+
+    beginBit();
+    return false;
+}
+
+} // namespace tt09_levenshtein
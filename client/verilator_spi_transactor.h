@@ -0,0 +1,51 @@
+#pragma once
+
+#include "verilator_context.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace tt09_levenshtein
+{
+
+// SPI master (mode 3) driving the pins of the Verilator model from within the simulation clock loop
+//
+// A transfer shifts out all of data and then shifts in all of buffer, spending clockDivider clock cycles per bit.
+// The completion handler is invoked once the last bit has been clocked.
+class VerilatorSpiTransactor
+{
+public:
+    VerilatorSpiTransactor(VerilatorContext& context, unsigned int clockDivider) noexcept;
+
+    template<typename CompletionToken>
+    auto asyncTransfer(std::span<const std::byte> data, std::span<std::byte> buffer, CompletionToken&& token)
+    {
+        start(data, buffer);
+        return m_context.asyncWaitUntil([this]() { return clock(); }, std::forward<CompletionToken>(token));
+    }
+
+private:
+    enum class Phase
+    {
+        Low,
+        High
+    };
+
+    void start(std::span<const std::byte> data, std::span<std::byte> buffer) noexcept;
+    void beginBit() noexcept;
+    bool clock() noexcept;
+
+    VerilatorContext& m_context;
+    unsigned int m_lowClocks;
+    unsigned int m_highClocks;
+    std::span<const std::byte> m_data;
+    std::span<std::byte> m_buffer;
+    std::size_t m_bit = 0;
+    std::size_t m_bitCount = 0;
+    Phase m_phase = Phase::Low;
+    unsigned int m_countdown = 0;
+    std::uint8_t m_valueIn = 0;
+};
+
+} // namespace tt09_levenshtein
@@ -0,0 +1,65 @@
+#include "word_list.h"
+
+#include <fmt/format.h>
+
+#include <limits>
+#include <stdexcept>
+
+namespace tt09_levenshtein
+{
+
+WordList::WordList()
+    : m_offsets{0}
+{
+}
+
+std::string_view WordList::at(std::size_t index) const
+{
+    if (index >= size())
+    {
+        throw std::out_of_range(fmt::format("Word index {} is out of range", index));
+    }
+    return (*this)[index];
+}
+
+void WordList::reserve(std::size_t words, std::size_t bytes)
+{
+    m_offsets.reserve(words + 1);
+    m_arena.reserve(bytes);
+}
+
+void WordList::push_back(std::string_view word)
+{
+    if (m_arena.size() + word.size() + 1 > std::numeric_limits<std::uint32_t>::max())
+    {
+        throw std::length_error("Word list exceeds 4 GiB");
+    }
+
+    m_arena.append(word);
+    m_arena.push_back('\0');
+    m_offsets.push_back(static_cast<std::uint32_t>(m_arena.size()));
+}
+
+void WordList::append(const WordList& words)
+{
+    if (m_arena.size() + words.m_arena.size() > std::numeric_limits<std::uint32_t>::max())
+    {
+        throw std::length_error("Word list exceeds 4 GiB");
+    }
+
+    auto base = static_cast<std::uint32_t>(m_arena.size());
+    m_arena.append(words.m_arena);
+    m_offsets.reserve(m_offsets.size() + words.size());
+    for (auto it = words.m_offsets.begin() + 1; it != words.m_offsets.end(); ++it)
+    {
+        m_offsets.push_back(base + *it);
+    }
+}
+
+void WordList::clear() noexcept
+{
+    m_arena.clear();
+    m_offsets.resize(1);
+}
+
+} // namespace tt09_levenshtein
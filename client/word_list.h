@@ -0,0 +1,169 @@
+#pragma once
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tt09_levenshtein
+{
+
+// Words stored back to back in one buffer, each followed by a NUL terminator
+//
+// This takes one allocation for all the words instead of one per word. Since the terminator is the word terminator
+// of the device dictionary format, the buffer of a list of mapped words is also the plain dictionary image, except
+// for the list terminator.
+class WordList
+{
+public:
+    class Iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = std::string_view;
+
+        constexpr Iterator() noexcept = default;
+
+        constexpr Iterator(const WordList* list, std::size_t index) noexcept
+            : m_list(list)
+            , m_index(index)
+        {
+        }
+
+        std::string_view operator*() const noexcept
+        {
+            return (*m_list)[m_index];
+        }
+
+        std::string_view operator[](difference_type offset) const noexcept
+        {
+            return (*m_list)[m_index + offset];
+        }
+
+        constexpr Iterator& operator++() noexcept
+        {
+            ++m_index;
+            return *this;
+        }
+
+        constexpr Iterator operator++(int) noexcept
+        {
+            auto it = *this;
+            ++m_index;
+            return it;
+        }
+
+        constexpr Iterator& operator--() noexcept
+        {
+            --m_index;
+            return *this;
+        }
+
+        constexpr Iterator operator--(int) noexcept
+        {
+            auto it = *this;
+            --m_index;
+            return it;
+        }
+
+        constexpr Iterator& operator+=(difference_type offset) noexcept
+        {
+            m_index += offset;
+            return *this;
+        }
+
+        constexpr Iterator& operator-=(difference_type offset) noexcept
+        {
+            m_index -= offset;
+            return *this;
+        }
+
+        friend constexpr Iterator operator+(Iterator it, difference_type offset) noexcept
+        {
+            return it += offset;
+        }
+
+        friend constexpr Iterator operator+(difference_type offset, Iterator it) noexcept
+        {
+            return it += offset;
+        }
+
+        friend constexpr Iterator operator-(Iterator it, difference_type offset) noexcept
+        {
+            return it -= offset;
+        }
+
+        friend constexpr difference_type operator-(const Iterator& a, const Iterator& b) noexcept
+        {
+            return static_cast<difference_type>(a.m_index) - static_cast<difference_type>(b.m_index);
+        }
+
+        friend constexpr bool operator==(const Iterator& a, const Iterator& b) noexcept
+        {
+            return a.m_index == b.m_index;
+        }
+
+        friend constexpr auto operator<=>(const Iterator& a, const Iterator& b) noexcept
+        {
+            return a.m_index <=> b.m_index;
+        }
+
+    private:
+        const WordList* m_list = nullptr;
+        std::size_t m_index = 0;
+    };
+
+    WordList();
+
+    std::size_t size() const noexcept
+    {
+        return m_offsets.size() - 1;
+    }
+
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    std::string_view operator[](std::size_t index) const noexcept
+    {
+        return std::string_view(m_arena).substr(m_offsets[index], m_offsets[index + 1] - m_offsets[index] - 1);
+    }
+
+    std::string_view at(std::size_t index) const;
+
+    Iterator begin() const noexcept
+    {
+        return Iterator(this, 0);
+    }
+
+    Iterator end() const noexcept
+    {
+        return Iterator(this, size());
+    }
+
+    // All words with their terminators
+    std::span<const std::byte> bytes() const noexcept
+    {
+        return std::as_bytes(std::span(m_arena));
+    }
+
+    void reserve(std::size_t words, std::size_t bytes);
+    void push_back(std::string_view word);
+    void append(const WordList& words);
+    void clear() noexcept;
+
+private:
+    std::string m_arena;
+    // Start of each word followed by the end of the arena, so that word n spans [m_offsets[n], m_offsets[n + 1] - 1)
+    std::vector<std::uint32_t> m_offsets;
+};
+
+} // namespace tt09_levenshtein
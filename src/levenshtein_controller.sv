@@ -5,7 +5,13 @@ module levenshtein_controller
         parameter int unsigned MASTER_ADDR_WIDTH=24,
         parameter int unsigned SLAVE_ADDR_WIDTH=24,
         parameter int unsigned BITVECTOR_WIDTH=16,
-        parameter int unsigned BURST_SIZE=4
+        parameter int unsigned BURST_SIZE=4,
+        parameter int unsigned PERF_COUNTER_WIDTH=32,
+        parameter int unsigned PREFIX_STACK_DEPTH=0,    //! Number of prefix states kept for front coded dictionaries. 0 disables front coding
+        parameter int unsigned VECTOR_CACHE_SIZE=0,     //! Number of bitvectors the host can load into the engine. 0 disables the vector cache
+        parameter int unsigned DICT_PREFETCH=0,         //! Fetch the next dictionary burst while the current one is processed
+        parameter int unsigned NUM_ENGINES=1,           //! Number of dictionary partitions scanned in parallel. More than 1 requires the vector cache and doesn't reduce latency, as the engines share one PSRAM port
+        parameter int unsigned FILL_DMA=0               //! Let the host fill SRAM regions with a byte value through FILL
     )
     (
         input wire clk_i,
@@ -67,21 +73,66 @@ module levenshtein_controller
     localparam WORD_LENGTH_REG_WIDTH = $clog2(BITVECTOR_WIDTH);
     localparam WORD_LENGTH_WIDTH = $clog2(BITVECTOR_WIDTH + 1);
 
-    localparam ADDR_CTRL = 3'd0;
-    localparam ADDR_SRAM_CTRL = 3'd1;
-    localparam ADDR_LENGTH = 3'd2;
-    localparam ADDR_MAX_LENGTH = 3'd3;
-    localparam ADDR_INDEX_HI = 3'd4;
-    localparam ADDR_INDEX_LO = 3'd5;
-    localparam ADDR_DISTANCE = 3'd6;
+    localparam ADDR_CTRL = 5'h00;
+    localparam ADDR_SRAM_CTRL = 5'h01;
+    localparam ADDR_LENGTH = 5'h02;
+    localparam ADDR_MAX_LENGTH = 5'h03;
+    localparam ADDR_INDEX_HI = 5'h04;
+    localparam ADDR_INDEX_LO = 5'h05;
+    localparam ADDR_DISTANCE = 5'h06;
+    localparam ADDR_PREFIX_DEPTH = 5'h07;
+    localparam ADDR_CYCLES = 5'h08;
+    localparam ADDR_DICT_STALLS = 5'h0C;
+    localparam ADDR_VECTOR_STALLS = 5'h10;
+    localparam ADDR_DICT_BYTES = 5'h14;
+    localparam ADDR_WORDS = 5'h18;
+    localparam ADDR_VECTOR_CACHE = 5'h1C;
+    localparam ADDR_ENGINES = 5'h1D;
+    localparam ADDR_ENGINE = 5'h1E;
+    localparam ADDR_FILL = 5'h1F;
     
     localparam WORD_TERMINATOR = 8'h00;
     localparam DICT_TERMINATOR = 8'h01;
 
+    // In a front coded dictionary, each word starts with a header byte holding the shared prefix length plus this
+    localparam PREFIX_HEADER_OFFSET = 8'h02;
+
+    // The prefix stack is only available to a single engine, so with more engines it isn't built at all
+    localparam PREFIX_DEPTH = NUM_ENGINES == 1 ? PREFIX_STACK_DEPTH : 0;
+
+    localparam STACK_SLOTS = PREFIX_DEPTH > 0 ? PREFIX_DEPTH : 1;
+    localparam STACK_INDEX_WIDTH = $clog2(STACK_SLOTS + 1);
+    localparam STACK_ADDR_WIDTH = STACK_SLOTS > 1 ? $clog2(STACK_SLOTS) : 1;
+
+    localparam CACHE_SLOTS = VECTOR_CACHE_SIZE > 0 ? VECTOR_CACHE_SIZE : 1;
+    localparam CACHE_COUNT_WIDTH = $clog2(CACHE_SLOTS + 1);
+    localparam CACHE_ADDR_WIDTH = CACHE_SLOTS > 1 ? $clog2(CACHE_SLOTS) : 1;
+    localparam CACHE_BYTE_WIDTH = $clog2(BITVECTOR_BYTES + 1);
+
+    // A fill command is streamed as a 24-bit address, a 24-bit length and the value, all big endian
+    localparam FILL_COMMAND_BYTES = 7;
+    localparam FILL_BYTE_WIDTH = $clog2(FILL_COMMAND_BYTES);
+
+    // Fills are written in aligned bursts of this many bytes, so that a burst never crosses an SRAM page
+    localparam FILL_BURST_SIZE = 32;
+    localparam FILL_BURST_WIDTH = $clog2(FILL_BURST_SIZE);
+
+    // With multiple engines, the dictionary is interleaved so that each group of NUM_ENGINES bytes holds the next
+    // symbol of each partition
+    localparam GROUP_WIDTH = NUM_ENGINES * 8;
+    localparam LANE_SLOTS = NUM_ENGINES > 1 ? NUM_ENGINES - 1 : 1;
+    localparam ENGINE_WIDTH = NUM_ENGINES > 1 ? $clog2(NUM_ENGINES) : 1;
+
     localparam REAL_DICT_ADDR = MASTER_ADDR_WIDTH'({10'b10_00000000, BITVECTOR_ADDR_SUFFIX_WIDTH'(0)});
     localparam DICT_ADDR = REAL_DICT_ADDR[MASTER_ADDR_WIDTH - 1 -: DICT_ADDR_WIDTH];
 
     logic enabled;
+    // A start written to CTRL waits here until the bus is free of prefetches and fills
+    logic start_pending;
+    logic [2:1] start_flags;
+    logic prefix_mode;
+    logic expect_header;
+    logic cache_mode;
     logic [WORD_LENGTH_REG_WIDTH - 1 : 0] word_length_reg;
     wire [BITVECTOR_WIDTH - 1 : 0] mask;
     wire [BITVECTOR_WIDTH - 1 : 0] initial_vp;
@@ -104,25 +155,105 @@ module levenshtein_controller
     logic [BITVECTOR_WIDTH - 1 : 0] vp;
     logic [BITVECTOR_WIDTH - 1 : 0] vn;
     logic [DISTANCE_WIDTH - 1 : 0] d;
+    logic [DISTANCE_WIDTH - 1 : 0] next_d;
+
+    // stack_*[n] holds the state after the first n + 1 symbols of the current word
+    logic [BITVECTOR_WIDTH - 1 : 0] stack_vp [STACK_SLOTS];
+    logic [BITVECTOR_WIDTH - 1 : 0] stack_vn [STACK_SLOTS];
+    logic [DISTANCE_WIDTH - 1 : 0] stack_d [STACK_SLOTS];
+    logic [STACK_INDEX_WIDTH - 1 : 0] depth;
+    wire [7:0] prefix_length;
+
+    // Bitvectors of the query alphabet, streamed in by the host as a symbol byte followed by the vector in big endian
+    logic [7:0] cache_symbol [CACHE_SLOTS];
+    logic [BITVECTOR_WIDTH - 1 : 0] cache_vector [CACHE_SLOTS];
+    logic [CACHE_COUNT_WIDTH - 1 : 0] cache_count;
+    logic [CACHE_BYTE_WIDTH - 1 : 0] cache_byte;
+    logic [BITVECTOR_WIDTH - 1 : 0] cache_shift;
+    logic [BITVECTOR_WIDTH - 1 : 0] cached_pm;
+
+    // Engines 1 and up. They always take their bitvectors from the cache, so they step directly in STATE_PROCESS while
+    // engine 0 runs the regular state machine on the first symbol of each group
+    logic [7:0] lane_symbol [LANE_SLOTS];
+    logic [BITVECTOR_WIDTH - 1 : 0] lane_vp [LANE_SLOTS];
+    logic [BITVECTOR_WIDTH - 1 : 0] lane_vn [LANE_SLOTS];
+    logic [DISTANCE_WIDTH - 1 : 0] lane_d [LANE_SLOTS];
+    logic [BITVECTOR_WIDTH - 1 : 0] lane_next_vp [LANE_SLOTS];
+    logic [BITVECTOR_WIDTH - 1 : 0] lane_next_vn [LANE_SLOTS];
+    logic [DISTANCE_WIDTH - 1 : 0] lane_next_d [LANE_SLOTS];
+    logic [ID_WIDTH - 1 : 0] lane_idx [LANE_SLOTS];
+    logic [ID_WIDTH - 1 : 0] lane_best_idx [LANE_SLOTS];
+    logic [DISTANCE_WIDTH - 1 : 0] lane_best_distance [LANE_SLOTS];
+    logic [BITVECTOR_WIDTH - 1 : 0] lane_pm;
+    logic [BITVECTOR_WIDTH - 1 : 0] lane_d0;
+    logic [BITVECTOR_WIDTH - 1 : 0] lane_hp;
+    logic [BITVECTOR_WIDTH - 1 : 0] lane_hn;
+    logic group_done;
+
+    logic [ENGINE_WIDTH - 1 : 0] result_engine;
+    logic [ID_WIDTH - 1 : 0] result_idx;
+    logic [DISTANCE_WIDTH - 1 : 0] result_distance;
+    logic [31:0] word_count;
 
     logic [ID_WIDTH - 1 : 0] idx;
     logic [ID_WIDTH - 1 : 0] best_idx;
     logic [DISTANCE_WIDTH - 1 : 0] best_distance;
 
+    logic [PERF_COUNTER_WIDTH - 1 : 0] cycle_counter;
+    logic [PERF_COUNTER_WIDTH - 1 : 0] dict_stall_counter;
+    logic [PERF_COUNTER_WIDTH - 1 : 0] vector_stall_counter;
+    wire [31:0] dict_bytes;
+    logic [31:0] perf_counter;
+    wire in_dict_state;
+    wire in_vector_state;
+
     logic [BURST_SIZE * 8 - 1 : 0] symbols;
     logic [SYMBOL_INDEX_WIDTH - 1 : 0] symbol_idx;
+
+    // Second symbol buffer, filled by the prefetcher whenever the bus isn't needed for bitvectors
+    logic [BURST_SIZE * 8 - 1 : 0] fetch_symbols;
+    logic [SYMBOL_INDEX_WIDTH - 1 : 0] fetch_idx;
+    logic fetch_cyc;
+    logic fetch_full;
+    wire fetch_start;
+    wire dict_stall;
+    wire vector_stall;
+
     wire [7:0] next_symbol;
     wire [7:0] symbol;
 
+    // Fill engine, which writes fill_value to fill_length bytes from fill_address while fill_cyc is set
+    logic [FILL_BYTE_WIDTH - 1 : 0] fill_byte;
+    logic [MASTER_ADDR_WIDTH - 1 : 0] fill_address;
+    logic [MASTER_ADDR_WIDTH - 1 : 0] fill_length;
+    logic [7:0] fill_value;
+    logic fill_cyc;
+    wire fill_last;
+    // Set when a fill command byte is refused because the bus is busy. The rest of that command is refused too, until
+    // the host has seen the flag by reading FILL
+    logic fill_rejected;
+    wire fill_refused;
+    logic wbs_err;
+
     integer i;
     integer j;
+    integer k;
+    integer l;
+    integer m;
+    integer n;
+
+    generate
+        if (NUM_ENGINES > 1 && (VECTOR_CACHE_SIZE == 0 || BURST_SIZE % NUM_ENGINES != 0)) begin : g_engine_check
+            $error("Multiple engines require the vector cache and a BURST_SIZE divisible by NUM_ENGINES");
+        end
+    endgenerate
 
-    assign wbs_err_o = 1'b0;
+    assign wbs_err_o = wbs_err;
     assign wbs_rty_o = 1'b0;
-    assign wbm_cyc_o = cyc;
-    assign wbm_stb_o = cyc;
-    assign wbm_we_o = 1'b0;
-    assign wbm_dat_o = 8'h00;
+    assign wbm_cyc_o = cyc || fetch_cyc || fill_cyc;
+    assign wbm_stb_o = cyc || fetch_cyc || fill_cyc;
+    assign wbm_we_o = fill_cyc;
+    assign wbm_dat_o = fill_value;
     assign word_length = WORD_LENGTH_WIDTH'(word_length_reg) + WORD_LENGTH_WIDTH'(1);
 
     assign d0 = (((pm & vp) + vp) ^ vp) | pm | vn;
@@ -134,8 +265,107 @@ module levenshtein_controller
     assign initial_vp = (1 << word_length) - 1;
     assign mask = 1 << (word_length - 1);
 
+    always_comb begin
+        if ((hp & mask) != BITVECTOR_WIDTH'(0)) begin
+            next_d = d + DISTANCE_WIDTH'(1);
+        end else if ((hn & mask) != BITVECTOR_WIDTH'(0)) begin
+            next_d = d - DISTANCE_WIDTH'(1);
+        end else begin
+            next_d = d;
+        end
+    end
+
+    assign prefix_length = next_symbol - PREFIX_HEADER_OFFSET;
+
+    // Symbols which aren't in the cache don't occur in the query, so they match nothing
+    always_comb begin
+        cached_pm = BITVECTOR_WIDTH'(0);
+        for (k = 0; k != CACHE_SLOTS; k = k + 1) begin
+            if (CACHE_COUNT_WIDTH'(k) < cache_count && cache_symbol[k] == next_symbol) begin
+                cached_pm = cache_vector[k];
+            end
+        end
+    end
+
+    always_comb begin
+        group_done = next_symbol == DICT_TERMINATOR;
+        for (l = 0; l != LANE_SLOTS; l = l + 1) begin
+            lane_symbol[l] = symbols[(l + 1) * 8 +: 8];
+            if (NUM_ENGINES > 1 && lane_symbol[l] != DICT_TERMINATOR) begin
+                group_done = 1'b0;
+            end
+
+            lane_pm = BITVECTOR_WIDTH'(0);
+            for (m = 0; m != CACHE_SLOTS; m = m + 1) begin
+                if (CACHE_COUNT_WIDTH'(m) < cache_count && cache_symbol[m] == lane_symbol[l]) begin
+                    lane_pm = cache_vector[m];
+                end
+            end
+
+            lane_d0 = (((lane_pm & lane_vp[l]) + lane_vp[l]) ^ lane_vp[l]) | lane_pm | lane_vn[l];
+            lane_hp = lane_vn[l] | ~(lane_d0 | lane_vp[l]);
+            lane_hn = lane_d0 & lane_vp[l];
+            lane_next_vp[l] = (lane_hn << 1) | ~(lane_d0 | ((lane_hp << 1) | BITVECTOR_WIDTH'(1)));
+            lane_next_vn[l] = lane_d0 & ((lane_hp << 1) | BITVECTOR_WIDTH'(1));
+            if ((lane_hp & mask) != BITVECTOR_WIDTH'(0)) begin
+                lane_next_d[l] = lane_d[l] + DISTANCE_WIDTH'(1);
+            end else if ((lane_hn & mask) != BITVECTOR_WIDTH'(0)) begin
+                lane_next_d[l] = lane_d[l] - DISTANCE_WIDTH'(1);
+            end else begin
+                lane_next_d[l] = lane_d[l];
+            end
+        end
+    end
+
+    // The lowest distance wins. Engines hold consecutive partitions, so on a tie the lowest engine has the lowest index
+    always_comb begin
+        result_engine = ENGINE_WIDTH'(0);
+        result_idx = best_idx;
+        result_distance = best_distance;
+        word_count = 32'(idx);
+        for (n = 0; n != LANE_SLOTS; n = n + 1) begin
+            if (NUM_ENGINES > 1) begin
+                if (lane_best_distance[n] < result_distance) begin
+                    result_engine = ENGINE_WIDTH'(n + 1);
+                    result_idx = lane_best_idx[n];
+                    result_distance = lane_best_distance[n];
+                end
+                word_count = word_count + 32'(lane_idx[n]);
+            end
+        end
+    end
+
     assign next_symbol = symbols[7:0];
-    assign symbol = symbols[BURST_SIZE * 8 - 1 -: 8];
+    assign symbol = symbols[BURST_SIZE * 8 - GROUP_WIDTH +: 8];
+
+    assign in_dict_state = state < STATE_PROCESS;
+    assign in_vector_state = state >= STATE_READ_VECTOR_BASE;
+
+    assign fetch_start = DICT_PREFETCH != 0 && enabled && !fetch_full && !fetch_cyc && !cyc && !in_vector_state;
+
+    assign fill_last = fill_length == MASTER_ADDR_WIDTH'(1) || fill_address[FILL_BURST_WIDTH - 1 : 0] == FILL_BURST_WIDTH'(FILL_BURST_SIZE - 1);
+
+    // With prefetching, STATE_READ_DICT_BASE only waits for the prefetch buffer, and bitvector reads may have to wait
+    // for a burst in flight
+    assign dict_stall = DICT_PREFETCH != 0 ? state == STATE_READ_DICT_BASE && !fetch_full : in_dict_state && cyc && !wbm_ack_i;
+    assign vector_stall = in_vector_state && (cyc || fetch_cyc) && !(cyc && wbm_ack_i);
+
+    // The dictionary byte and word counters are derived from the scan position rather than being counted separately
+    assign dict_bytes = 32'(dict_address - DICT_ADDR) << DICT_ADDR_SUFFIX_WIDTH;
+
+    assign fill_refused = FILL_DMA != 0 && wbs_we_i && wbs_adr_i[4:0] == ADDR_FILL && (enabled || start_pending || fetch_cyc || fill_cyc || fill_rejected);
+
+    always_comb begin
+        case (wbs_adr_i[4:2])
+            ADDR_CYCLES[4:2]: perf_counter = 32'(cycle_counter);
+            ADDR_DICT_STALLS[4:2]: perf_counter = 32'(dict_stall_counter);
+            ADDR_VECTOR_STALLS[4:2]: perf_counter = 32'(vector_stall_counter);
+            ADDR_DICT_BYTES[4:2]: perf_counter = dict_bytes;
+            ADDR_WORDS[4:2]: perf_counter = word_count;
+            ADDR_VECTOR_CACHE[4:2]: perf_counter = {8'(VECTOR_CACHE_SIZE), 8'(NUM_ENGINES), 8'(result_engine), 5'b00000, fill_rejected, fill_cyc, 1'(FILL_DMA != 0)};
+            default: perf_counter = 32'h00000000;
+        endcase
+    end
 
     always_comb begin
         wbm_adr_o = MASTER_ADDR_WIDTH'(0);
@@ -143,7 +373,7 @@ module levenshtein_controller
         wbm_bte_o = 2'b00;
 
         for (i = 0; i != BURST_SIZE; i = i + 1) begin
-            if (state == STATE_READ_DICT_BASE + STATE_WIDTH'(i)) begin
+            if (DICT_PREFETCH != 0 ? fetch_cyc && fetch_idx == SYMBOL_INDEX_WIDTH'(i) : state == STATE_READ_DICT_BASE + STATE_WIDTH'(i)) begin
                 if (BURST_SIZE == 1) begin
                     wbm_adr_o = MASTER_ADDR_WIDTH'(dict_address);
                 end else begin
@@ -163,7 +393,7 @@ module levenshtein_controller
         end
         
         for (i = 0; i != BITVECTOR_BYTES; i = i + 1) begin
-            if (state == STATE_READ_VECTOR_BASE + STATE_WIDTH'(i)) begin
+            if (state == STATE_READ_VECTOR_BASE + STATE_WIDTH'(i) && !fetch_cyc) begin
                 wbm_adr_o = MASTER_ADDR_WIDTH'({1'b1, symbol, BITVECTOR_ADDR_SUFFIX_WIDTH'(i)});
                 if (BITVECTOR_BYTES == 1) begin
                     wbm_cti_o = CTI_CLASSIC;
@@ -177,59 +407,178 @@ module levenshtein_controller
                 end
             end
         end
+
+        if (fill_cyc) begin
+            wbm_adr_o = fill_address;
+            if (fill_last) begin
+                wbm_cti_o = CTI_END_OF_BURST;
+                wbm_bte_o = 2'b00;
+            end else begin
+                wbm_cti_o = CTI_INCREMENTAL_BURST;
+                wbm_bte_o = BTE_LINEAR_BURST;
+            end
+        end
     end
 
     always_comb begin
-        case (wbs_adr_i[2:0])
-            ADDR_CTRL: wbs_dat_o = {7'b0000000, enabled};
-            ADDR_SRAM_CTRL: wbs_dat_o = {6'b000000, sram_config};
-            ADDR_LENGTH: wbs_dat_o = 8'(word_length_reg);
-            ADDR_MAX_LENGTH: wbs_dat_o = 8'(BITVECTOR_WIDTH - 1);
-            ADDR_INDEX_HI: wbs_dat_o = best_idx[15:8];
-            ADDR_INDEX_LO: wbs_dat_o = best_idx[7:0];
-            ADDR_DISTANCE: wbs_dat_o = best_distance;
-            default: wbs_dat_o = 8'h00;
-        endcase
+        if (wbs_adr_i[4:3] != 2'b00) begin
+            case (wbs_adr_i[1:0])
+                2'd0: wbs_dat_o = perf_counter[31:24];
+                2'd1: wbs_dat_o = perf_counter[23:16];
+                2'd2: wbs_dat_o = perf_counter[15:8];
+                default: wbs_dat_o = perf_counter[7:0];
+            endcase
+        end else begin
+            case (wbs_adr_i[4:0])
+                ADDR_CTRL: wbs_dat_o = {5'b00000, cache_mode, prefix_mode, enabled || start_pending};
+                ADDR_SRAM_CTRL: wbs_dat_o = {6'b000000, sram_config};
+                ADDR_LENGTH: wbs_dat_o = 8'(word_length_reg);
+                ADDR_MAX_LENGTH: wbs_dat_o = 8'(BITVECTOR_WIDTH - 1);
+                ADDR_INDEX_HI: wbs_dat_o = result_idx[15:8];
+                ADDR_INDEX_LO: wbs_dat_o = result_idx[7:0];
+                ADDR_DISTANCE: wbs_dat_o = result_distance;
+                ADDR_PREFIX_DEPTH: wbs_dat_o = 8'(PREFIX_DEPTH);
+                default: wbs_dat_o = 8'h00;
+            endcase
+        end
     end
 
     always @ (posedge clk_i) begin
         if (rst_i) begin
             enabled <= 1'b0;
+            start_pending <= 1'b0;
+            prefix_mode <= 1'b0;
+            cache_mode <= 1'b0;
+            cache_count <= CACHE_COUNT_WIDTH'(0);
+            cache_byte <= CACHE_BYTE_WIDTH'(0);
             wbs_ack_o <= 1'b0;
+            wbs_err <= 1'b0;
 
             cyc <= 1'b0;
+            fetch_cyc <= 1'b0;
+            fetch_full <= 1'b0;
+            fill_byte <= FILL_BYTE_WIDTH'(0);
+            fill_cyc <= 1'b0;
+            fill_rejected <= 1'b0;
         end else begin
-            if (wbs_cyc_i && wbs_stb_i && !wbs_ack_o) begin
-                if (wbs_we_i) begin
-                    if (wbs_adr_i[2:0] == ADDR_CTRL) begin
-                        enabled <= wbs_dat_i[0];
-                        if (!enabled) begin
-                            state <= STATE_READ_DICT_BASE;
+            // Starting while a burst prefetched past the end of the dictionary is still in flight, or while a fill owns
+            // the bus, would mix up their acks with the ones of the new search
+            if (start_pending && !fetch_cyc && !fill_cyc) begin
+                start_pending <= 1'b0;
+                enabled <= 1'b1;
+                prefix_mode <= PREFIX_DEPTH != 0 && start_flags[1];
+                expect_header <= PREFIX_DEPTH != 0 && start_flags[1];
+                depth <= STACK_INDEX_WIDTH'(0);
+                cache_mode <= VECTOR_CACHE_SIZE != 0 && (start_flags[2] || NUM_ENGINES > 1);
+                state <= STATE_READ_DICT_BASE;
+
+                dict_address <= DICT_ADDR;
+                d <= DISTANCE_WIDTH'(word_length);
+                vn <= BITVECTOR_WIDTH'(0);
+                vp <= initial_vp;
+
+                idx <= ID_WIDTH'(0);
+                best_idx <= ID_WIDTH'(0);
+                best_distance <= DISTANCE_WIDTH'(-1);
+                symbol_idx <= SYMBOL_INDEX_WIDTH'(0);
+                fetch_idx <= SYMBOL_INDEX_WIDTH'(0);
+                fetch_full <= 1'b0;
+
+                for (j = 0; j != LANE_SLOTS; j = j + 1) begin
+                    lane_d[j] <= DISTANCE_WIDTH'(word_length);
+                    lane_vn[j] <= BITVECTOR_WIDTH'(0);
+                    lane_vp[j] <= initial_vp;
+                    lane_idx[j] <= ID_WIDTH'(0);
+                    lane_best_idx[j] <= ID_WIDTH'(0);
+                    lane_best_distance[j] <= DISTANCE_WIDTH'(-1);
+                end
 
-                            dict_address <= DICT_ADDR;
-                            d <= DISTANCE_WIDTH'(word_length);
-                            vn <= BITVECTOR_WIDTH'(0);
-                            vp <= initial_vp;
+                cycle_counter <= PERF_COUNTER_WIDTH'(0);
+                dict_stall_counter <= PERF_COUNTER_WIDTH'(0);
+                vector_stall_counter <= PERF_COUNTER_WIDTH'(0);
+            end
+
+            if (wbs_cyc_i && wbs_stb_i && !wbs_ack_o && !wbs_err) begin
+                if (fill_refused) begin
+                    // The command can't be completed, so it starts over from the first byte
+                    fill_rejected <= 1'b1;
+                    fill_byte <= FILL_BYTE_WIDTH'(0);
+                end else if (wbs_we_i) begin
+                    // Writing any other register abandons a partially written fill command
+                    if (wbs_adr_i[4:0] != ADDR_FILL) begin
+                        fill_byte <= FILL_BYTE_WIDTH'(0);
+                    end
 
-                            idx <= ID_WIDTH'(0);
-                            best_idx <= ID_WIDTH'(0);
-                            best_distance <= DISTANCE_WIDTH'(-1);
-                            symbol_idx <= SYMBOL_INDEX_WIDTH'(0);
+                    if (wbs_adr_i[4:0] == ADDR_CTRL) begin
+                        // Writing 1 while a search is running leaves it running, and writing 0 aborts it
+                        if (!wbs_dat_i[0]) begin
+                            enabled <= 1'b0;
+                            start_pending <= 1'b0;
+                        end else if (!enabled) begin
+                            start_pending <= 1'b1;
+                            start_flags <= wbs_dat_i[2:1];
                         end
-                    end else if (wbs_adr_i[2:0] == ADDR_SRAM_CTRL) begin
+                    end else if (wbs_adr_i[4:0] == ADDR_SRAM_CTRL) begin
                         sram_config <= wbs_dat_i[1:0];
-                    end else if (wbs_adr_i[2:0] == ADDR_LENGTH) begin
+                    end else if (wbs_adr_i[4:0] == ADDR_LENGTH) begin
+                        // A new query invalidates the cached bitvectors of the previous one
                         word_length_reg <= wbs_dat_i[WORD_LENGTH_REG_WIDTH - 1 : 0];
+                        cache_count <= CACHE_COUNT_WIDTH'(0);
+                        cache_byte <= CACHE_BYTE_WIDTH'(0);
+                    end else if (wbs_adr_i[4:0] == ADDR_VECTOR_CACHE && VECTOR_CACHE_SIZE != 0 && !enabled && !start_pending && cache_count != CACHE_COUNT_WIDTH'(VECTOR_CACHE_SIZE)) begin
+                        if (cache_byte == CACHE_BYTE_WIDTH'(0)) begin
+                            cache_symbol[CACHE_ADDR_WIDTH'(cache_count)] <= wbs_dat_i;
+                            cache_byte <= CACHE_BYTE_WIDTH'(1);
+                        end else if (cache_byte == CACHE_BYTE_WIDTH'(BITVECTOR_BYTES)) begin
+                            cache_vector[CACHE_ADDR_WIDTH'(cache_count)] <= BITVECTOR_WIDTH'({cache_shift, wbs_dat_i});
+                            cache_count <= cache_count + CACHE_COUNT_WIDTH'(1);
+                            cache_byte <= CACHE_BYTE_WIDTH'(0);
+                        end else begin
+                            cache_shift <= BITVECTOR_WIDTH'({cache_shift, wbs_dat_i});
+                            cache_byte <= cache_byte + CACHE_BYTE_WIDTH'(1);
+                        end
+                    end else if (wbs_adr_i[4:0] == ADDR_FILL && FILL_DMA != 0) begin
+                        if (fill_byte < FILL_BYTE_WIDTH'(3)) begin
+                            fill_address <= MASTER_ADDR_WIDTH'({fill_address, wbs_dat_i});
+                        end else if (fill_byte < FILL_BYTE_WIDTH'(6)) begin
+                            fill_length <= MASTER_ADDR_WIDTH'({fill_length, wbs_dat_i});
+                        end
+                        if (fill_byte == FILL_BYTE_WIDTH'(FILL_COMMAND_BYTES - 1)) begin
+                            fill_value <= wbs_dat_i;
+                            fill_cyc <= fill_length != MASTER_ADDR_WIDTH'(0);
+                            fill_byte <= FILL_BYTE_WIDTH'(0);
+                        end else begin
+                            fill_byte <= fill_byte + FILL_BYTE_WIDTH'(1);
+                        end
                     end
+                end else if (wbs_adr_i[4:0] == ADDR_FILL) begin
+                    fill_rejected <= 1'b0;
                 end
-                wbs_ack_o <= 1'b1;
+                // The SPI bridge can't pass errors on to the host, which has to check the rejected flag of FILL instead
+                wbs_ack_o <= !fill_refused;
+                wbs_err <= fill_refused;
             end else begin
                 wbs_ack_o <= 1'b0;
+                wbs_err <= 1'b0;
             end
         
             if (enabled) begin
+                cycle_counter <= cycle_counter + PERF_COUNTER_WIDTH'(1);
+                if (dict_stall) begin
+                    dict_stall_counter <= dict_stall_counter + PERF_COUNTER_WIDTH'(1);
+                end
+                if (vector_stall) begin
+                    vector_stall_counter <= vector_stall_counter + PERF_COUNTER_WIDTH'(1);
+                end
+
+                if (DICT_PREFETCH != 0 && state == STATE_READ_DICT_BASE && fetch_full) begin
+                    symbols <= fetch_symbols;
+                    fetch_full <= 1'b0;
+                    state <= STATE_PROCESS;
+                end
+
                 for (j = 0; j != BURST_SIZE; j = j + 1) begin
-                    if (state == STATE_READ_DICT_BASE + STATE_WIDTH'(j)) begin
+                    if (DICT_PREFETCH == 0 && state == STATE_READ_DICT_BASE + STATE_WIDTH'(j)) begin
                         if (j == 0 && !cyc) begin
                             cyc <= 1'b1;
                         end else if (wbm_ack_i) begin
@@ -249,9 +598,44 @@ module levenshtein_controller
                 end
 
                 if (state == STATE_PROCESS) begin
-                    symbol_idx <= symbol_idx + SYMBOL_INDEX_WIDTH'(1);
-                    symbols <= {symbols[7:0], symbols[BURST_SIZE * 8 - 1 : 8]};
-                    if (next_symbol == WORD_TERMINATOR) begin
+                    symbol_idx <= symbol_idx + SYMBOL_INDEX_WIDTH'(NUM_ENGINES);
+                    symbols <= (BURST_SIZE * 8)'({symbols, symbols} >> GROUP_WIDTH);
+
+                    // Padding after the end of a partition is made of DICT_TERMINATOR, which the other engines ignore
+                    for (j = 0; j != LANE_SLOTS; j = j + 1) begin
+                        if (NUM_ENGINES > 1 && lane_symbol[j] == WORD_TERMINATOR) begin
+                            if (lane_d[j] < lane_best_distance[j]) begin
+                                lane_best_idx[j] <= lane_idx[j];
+                                lane_best_distance[j] <= lane_d[j];
+                            end
+                            lane_idx[j] <= lane_idx[j] + ID_WIDTH'(1);
+                            lane_d[j] <= DISTANCE_WIDTH'(word_length);
+                            lane_vn[j] <= BITVECTOR_WIDTH'(0);
+                            lane_vp[j] <= initial_vp;
+                        end else if (NUM_ENGINES > 1 && lane_symbol[j] != DICT_TERMINATOR) begin
+                            lane_d[j] <= lane_next_d[j];
+                            lane_vp[j] <= lane_next_vp[j];
+                            lane_vn[j] <= lane_next_vn[j];
+                        end
+                    end
+
+                    if (expect_header && next_symbol != DICT_TERMINATOR) begin
+                        // Resume from the state after the shared prefix instead of starting the word over
+                        expect_header <= 1'b0;
+                        depth <= STACK_INDEX_WIDTH'(prefix_length);
+                        if (prefix_length == 8'd0) begin
+                            d <= DISTANCE_WIDTH'(word_length);
+                            vn <= BITVECTOR_WIDTH'(0);
+                            vp <= initial_vp;
+                        end else begin
+                            d <= stack_d[STACK_ADDR_WIDTH'(prefix_length - 8'd1)];
+                            vn <= stack_vn[STACK_ADDR_WIDTH'(prefix_length - 8'd1)];
+                            vp <= stack_vp[STACK_ADDR_WIDTH'(prefix_length - 8'd1)];
+                        end
+                        if (symbol_idx == SYMBOL_INDEX_WIDTH'(BURST_SIZE - NUM_ENGINES)) begin
+                            state <= STATE_READ_DICT_BASE;
+                        end
+                    end else if (next_symbol == WORD_TERMINATOR) begin
                         if (d < best_distance) begin
                             best_idx <= idx;
                             best_distance <= d;
@@ -260,11 +644,19 @@ module levenshtein_controller
                         d <= DISTANCE_WIDTH'(word_length);
                         vn <= BITVECTOR_WIDTH'(0);
                         vp <= initial_vp;
-                        if (symbol_idx == SYMBOL_INDEX_WIDTH'(BURST_SIZE - 1)) begin
+                        expect_header <= prefix_mode;
+                        if (symbol_idx == SYMBOL_INDEX_WIDTH'(BURST_SIZE - NUM_ENGINES)) begin
                             state <= STATE_READ_DICT_BASE;
                         end
                     end else if (next_symbol == DICT_TERMINATOR) begin
-                        enabled <= 1'b0;
+                        if (group_done) begin
+                            enabled <= 1'b0;
+                        end else if (symbol_idx == SYMBOL_INDEX_WIDTH'(BURST_SIZE - NUM_ENGINES)) begin
+                            state <= STATE_READ_DICT_BASE;
+                        end
+                    end else if (cache_mode) begin
+                        pm <= cached_pm;
+                        state <= STATE_LEVENSHTEIN;
                     end else begin
                         state <= STATE_READ_VECTOR_BASE;
                     end
@@ -273,7 +665,7 @@ module levenshtein_controller
                 for (j = 0; j != BITVECTOR_BYTES; j = j + 1) begin
                     if (state == STATE_READ_VECTOR_BASE + STATE_WIDTH'(j)) begin
                         if (j == 0 && !cyc) begin
-                            cyc <= 1'b1;
+                            cyc <= !fetch_cyc;
                         end else if (wbm_ack_i) begin
                             if (j == 0 && BITVECTOR_BYTES * 8 > BITVECTOR_WIDTH) begin
                                 pm[BITVECTOR_WIDTH - 1 : (BITVECTOR_BYTES - 1) * 8] <= wbm_dat_i[BITVECTOR_WIDTH - (BITVECTOR_BYTES - 1) * 8 - 1 : 0];
@@ -294,13 +686,15 @@ module levenshtein_controller
                 end
 
                 if (state == STATE_LEVENSHTEIN) begin
-                    if ((hp & mask) != BITVECTOR_WIDTH'(0)) begin
-                        d <= d + DISTANCE_WIDTH'(1);
-                    end else if ((hn & mask) != BITVECTOR_WIDTH'(0)) begin
-                        d <= d - DISTANCE_WIDTH'(1);
-                    end
+                    d <= next_d;
                     vp <= next_vp;
                     vn <= next_vn;
+                    if (prefix_mode && depth != STACK_INDEX_WIDTH'(PREFIX_DEPTH)) begin
+                        stack_d[STACK_ADDR_WIDTH'(depth)] <= next_d;
+                        stack_vp[STACK_ADDR_WIDTH'(depth)] <= next_vp;
+                        stack_vn[STACK_ADDR_WIDTH'(depth)] <= next_vn;
+                        depth <= depth + STACK_INDEX_WIDTH'(1);
+                    end
                     if (symbol_idx == SYMBOL_INDEX_WIDTH'(0)) begin
                         state <= STATE_READ_DICT_BASE;
                     end else begin
@@ -308,6 +702,36 @@ module levenshtein_controller
                     end
                 end
             end
+
+            // The prefetcher finishes a burst it has started even if the engine has stopped in the meantime
+            if (fetch_start) begin
+                fetch_cyc <= 1'b1;
+            end else if (fetch_cyc) begin
+                if (wbm_ack_i) begin
+                    fetch_symbols <= {wbm_dat_i, fetch_symbols[BURST_SIZE * 8 - 1 : 8]};
+                    fetch_idx <= fetch_idx + SYMBOL_INDEX_WIDTH'(1);
+                    if (fetch_idx == SYMBOL_INDEX_WIDTH'(BURST_SIZE - 1)) begin
+                        fetch_cyc <= 1'b0;
+                        fetch_full <= 1'b1;
+                        dict_address <= dict_address + DICT_ADDR_WIDTH'(1);
+                    end
+                end else if (wbm_err_i || wbm_rty_i) begin
+                    fetch_cyc <= 1'b0;
+                    enabled <= 1'b0;
+                end
+            end
+
+            if (fill_cyc) begin
+                if (wbm_ack_i) begin
+                    fill_address <= fill_address + MASTER_ADDR_WIDTH'(1);
+                    fill_length <= fill_length - MASTER_ADDR_WIDTH'(1);
+                    if (fill_length == MASTER_ADDR_WIDTH'(1)) begin
+                        fill_cyc <= 1'b0;
+                    end
+                end else if (wbm_err_i || wbm_rty_i) begin
+                    fill_cyc <= 1'b0;
+                end
+            end
         end
     end
 endmodule
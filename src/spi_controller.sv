@@ -1,6 +1,10 @@
 `default_nettype none
 
 module spi_controller
+    #(
+        parameter int unsigned MAX_SELECT_CYCLES=0,     //! Longest time SS# is held low to stream sequential reads, in clock cycles. 0 disables streaming
+        parameter int unsigned MIN_DESELECT_CYCLES=2    //! Shortest time SS# is held high between accesses (tCPH), in clock cycles
+    )
     (
         input wire clk_i,
         input wire rst_i,
@@ -40,21 +44,46 @@ module spi_controller
     localparam CONFIG_CS2 = 2'd2;
     localparam CONFIG_CS3 = 2'd3;
 
+    localparam SELECT_COUNTER_WIDTH = MAX_SELECT_CYCLES > 0 ? $clog2(MAX_SELECT_CYCLES + 1) : 1;
+
+    // Counts the cycles SS# has been high before the current one, up to the number needed before selecting again
+    localparam DESELECT_LIMIT = MIN_DESELECT_CYCLES > 1 ? MIN_DESELECT_CYCLES - 1 : 0;
+    localparam DESELECT_COUNTER_WIDTH = DESELECT_LIMIT > 0 ? $clog2(DESELECT_LIMIT + 1) : 1;
+
+    // Some PSRAMs can't continue a read across a page, so streams end at page boundaries
+    localparam PAGE_ADDR_WIDTH = 10;
+
     logic [7:0] read_command;
     logic [7:0] write_command;
     logic ss_n;
     logic [4:0] bit_counter;
     wire is_burst;
 
+    // While streaming, the chip stays selected with the clock stopped after a read, so that a read of the next address
+    // can continue without sending a new command and address
+    logic streaming;
+    logic [23:0] stream_adr;
+    logic [SELECT_COUNTER_WIDTH - 1 : 0] select_cycles;
+    wire can_stream;
+    wire keep_streaming;
+
+    // A broken stream is followed by a new command right away, so the deselect time has to be enforced. Other accesses
+    // end several cycles before the next one can start
+    logic [DESELECT_COUNTER_WIDTH - 1 : 0] deselect_cycles;
+    wire deselected;
+
     assign err_o = 1'b0;
     assign rty_o = 1'b0;
 
     assign cs_n = sram_config == CONFIG_CS ? ss_n : 1'b1;
     assign cs2_n = sram_config == CONFIG_CS2 ? ss_n : 1'b1;
     assign cs3_n = sram_config == CONFIG_CS3 ? ss_n : 1'b1;
-    assign is_burst = !we_i && cti_i == CTI_INCREMENTING_BURST && bte_i == BTE_LINEAR;
+    assign is_burst = cti_i == CTI_INCREMENTING_BURST && bte_i == BTE_LINEAR;
     assign read_command = 8'hEB;
     assign write_command = 8'h38;
+    assign can_stream = MAX_SELECT_CYCLES != 0 && select_cycles != SELECT_COUNTER_WIDTH'(MAX_SELECT_CYCLES);
+    assign deselected = deselect_cycles == DESELECT_COUNTER_WIDTH'(DESELECT_LIMIT);
+    assign keep_streaming = !we_i && !is_burst && can_stream && adr_i[PAGE_ADDR_WIDTH - 1 : 0] != {PAGE_ADDR_WIDTH{1'b1}};
 
     /*
         Signals
@@ -83,19 +112,53 @@ module spi_controller
         19          |                           | Receive data bit 7-4
         20          |                           | Receive data bit 3-0
 
+        In a read burst, bit_counter goes back to 20 after each byte. In a write burst, each byte is acknowledged as
+        soon as its last nibble is out and bit_counter goes back to 13 for the next one, so the chip stays selected
+        and the SRAM keeps incrementing the address.
 
+        When streaming, the last byte of a read also goes back to 20, but with the clock stopped. A read of the next
+        address restarts the clock from there, while any other access deselects the chip for MIN_DESELECT_CYCLES first
+        and starts over with a new command.
     */
 
     always @ (posedge clk_i) begin
-        if (rst_i || !cyc_i || !stb_i) begin
+        if (rst_i || ss_n) begin
+            select_cycles <= SELECT_COUNTER_WIDTH'(0);
+        end else if (can_stream) begin
+            select_cycles <= select_cycles + SELECT_COUNTER_WIDTH'(1);
+        end
+    end
+
+    always @ (posedge clk_i) begin
+        if (rst_i || !ss_n) begin
+            deselect_cycles <= DESELECT_COUNTER_WIDTH'(0);
+        end else if (!deselected) begin
+            deselect_cycles <= deselect_cycles + DESELECT_COUNTER_WIDTH'(1);
+        end
+    end
+
+    always @ (posedge clk_i) begin
+        if (rst_i || ((!cyc_i || !stb_i) && !streaming)) begin
             ack_o <= 1'b0;
             ss_n <= 1'b1;
             sck <= 1'b0;
             bit_counter <= 5'd0;
             sio_oe <= 4'b0000;
             sio_out <= 4'b0000;
+            streaming <= 1'b0;
+        end else if (streaming) begin
+            // The request which was just acknowledged may still be on the bus
+            if (ack_o) begin
+                ack_o <= 1'b0;
+            end else if (cyc_i && stb_i && !we_i && adr_i == stream_adr && can_stream) begin
+                streaming <= 1'b0;
+            end else if ((cyc_i && stb_i) || !can_stream) begin
+                streaming <= 1'b0;
+                ss_n <= 1'b1;
+                bit_counter <= 5'd0;
+            end
         end else begin
-            if (bit_counter == 5'd0) begin
+            if (bit_counter == 5'd0 && deselected) begin
                 ss_n <= 1'b0;
                 sio_oe <= 4'b0001;
                 sio_out[0] <= we_i ? write_command[7] : read_command[7];
@@ -120,6 +183,9 @@ module spi_controller
                     end
                     if (bit_counter == 5'd14) begin
                         sio_out <= dat_i[3:0];
+                        if (is_burst) begin
+                            ack_o <= 1'b1;
+                        end
                     end
                     if (bit_counter == 5'd15) begin
                         sio_oe <= 4'b0000;
@@ -132,7 +198,10 @@ module spi_controller
                     end
                     if (bit_counter == 5'd21) begin
                         ack_o <= 1'b1;
-                        if (!is_burst) begin
+                        if (keep_streaming) begin
+                            streaming <= 1'b1;
+                            stream_adr <= adr_i + 24'd1;
+                        end else if (!is_burst) begin
                             ss_n <= 1'b1;
                         end
                     end
@@ -144,8 +213,10 @@ module spi_controller
                 bit_counter <= 5'd0;
             end else if (!we_i && bit_counter == 5'd23) begin
                 bit_counter <= 5'd0;
-            end else if (sck && !we_i && bit_counter == 5'd21 && is_burst) begin
+            end else if (sck && !we_i && bit_counter == 5'd21 && (is_burst || keep_streaming)) begin
                 bit_counter <= 5'd20;
+            end else if (sck && we_i && bit_counter == 5'd14 && is_burst) begin
+                bit_counter <= 5'd13;
             end else if (sck) begin
                 bit_counter <= bit_counter + 5'd1;
             end
@@ -6,6 +6,20 @@
 `default_nettype none
 
 module tt_um_pchri03_levenshtein
+    #(
+        // Optional engine features. They are disabled by default to fit the tile, but can be enabled for simulation and FPGAs
+        parameter integer PREFIX_STACK_DEPTH = 0,
+        parameter integer VECTOR_CACHE_SIZE = 0,
+        parameter integer DICT_PREFETCH = 0,
+        parameter integer NUM_ENGINES = 1,
+        parameter integer FILL_DMA = 0,
+        // Routes register accesses through the SRAM arbiter as well, so they compete with the engine. Only useful to
+        // measure what the separate register path saves
+        parameter integer SHARED_BUS = 0,
+        // Keeps the SRAM selected between sequential reads for up to this many cycles, so they don't need a new command.
+        // The SRAM must allow SS# to stay low that long
+        parameter integer SPI_MAX_SELECT_CYCLES = 0
+    )
     /* verilator lint_off UNUSEDSIGNAL */
     (
         input  wire [7:0] ui_in,    // Dedicated inputs
@@ -83,7 +97,7 @@ module tt_um_pchri03_levenshtein
 
     wire ctrl_slave_cyc;
     wire ctrl_slave_stb;
-    wire [2:0] ctrl_slave_adr;
+    wire [4:0] ctrl_slave_adr;
     wire ctrl_slave_we;
     wire [7:0] ctrl_slave_dwr;
     wire [2:0] ctrl_slave_cti;
@@ -116,7 +130,16 @@ module tt_um_pchri03_levenshtein
         .dat_i(spi_drd)
     );
 
-    levenshtein_controller #(.MASTER_ADDR_WIDTH(23), .SLAVE_ADDR_WIDTH(3), .BITVECTOR_WIDTH(16)) levenshtein_ctrl (
+    levenshtein_controller #(
+        .MASTER_ADDR_WIDTH(23),
+        .SLAVE_ADDR_WIDTH(5),
+        .BITVECTOR_WIDTH(16),
+        .PREFIX_STACK_DEPTH(PREFIX_STACK_DEPTH),
+        .VECTOR_CACHE_SIZE(VECTOR_CACHE_SIZE),
+        .DICT_PREFETCH(DICT_PREFETCH),
+        .NUM_ENGINES(NUM_ENGINES),
+        .FILL_DMA(FILL_DMA)
+    ) levenshtein_ctrl (
         .clk_i(clk),
         .rst_i(!rst_n),
 
@@ -147,7 +170,9 @@ module tt_um_pchri03_levenshtein
         .sram_config(sram_config)
     );
 
-    spi_controller spi_ctrl(
+    spi_controller #(
+        .MAX_SELECT_CYCLES(SPI_MAX_SELECT_CYCLES)
+    ) spi_ctrl(
         .clk_i(clk),
         .rst_i(!rst_n),
 
@@ -174,7 +199,7 @@ module tt_um_pchri03_levenshtein
         .sram_config(sram_config)
     );
 
-    wb_interconnect #(.ADDR_WIDTH(23), .SHARED_BUS(0)) intercon(
+    wb_interconnect #(.ADDR_WIDTH(23), .SHARED_BUS(SHARED_BUS), .SLAVE0_ADDR_WIDTH(5)) intercon(
         .wbs_cyc_i(spi_cyc),
         .wbs_stb_i(spi_stb),
         .wbs_adr_i(spi_adr),
@@ -37,7 +37,8 @@ module qspi_sram
     wire [7:0] next_write_buffer;
     wire [7:0] next_write_buffer_quad;
 
-    reg [7:0] memory [16777215:0];
+    // Public so that Verilator testbenches can preload the memory without going through the SPI interface
+    reg [7:0] memory [16777215:0] /* verilator public_flat_rw */;
 
     reg [7:0] command;
     reg [23:0] address;
@@ -163,6 +164,7 @@ module qspi_sram
                 end
 
                 STATE_READ_QUAD: begin
+                    // Reads continue at the next address for as long as SS# is low, even if the clock stops in between
                     if (!sck) begin
                         sio_out <= read_buffer[7:4];
                         read_buffer <= next_read_buffer_quad;
@@ -4,7 +4,18 @@
 /* This testbench just instantiates the module and makes some convenient wires
    that can be driven / tested by the cocotb test.py.
 */
-module tb ();
+module tb
+    #(
+        // Optional features of the design, which test/Makefile sets for each CONFIG
+        parameter integer PREFIX_STACK_DEPTH = 0,
+        parameter integer VECTOR_CACHE_SIZE = 0,
+        parameter integer DICT_PREFETCH = 0,
+        parameter integer NUM_ENGINES = 1,
+        parameter integer FILL_DMA = 0,
+        parameter integer SPI_MAX_SELECT_CYCLES = 0,
+        parameter integer SHARED_BUS = 0
+    )
+    ();
     // Dump the signals to a VCD file. You can view it with gtkwave.
     initial begin
         $dumpfile("tb.vcd");
@@ -30,7 +41,19 @@ module tb ();
 `endif
 
     // Replace tt_um_example with your module name:
-    tt_um_pchri03_levenshtein user_project (
+    tt_um_pchri03_levenshtein
+`ifndef GL_TEST
+    #(
+        .PREFIX_STACK_DEPTH(PREFIX_STACK_DEPTH),
+        .VECTOR_CACHE_SIZE(VECTOR_CACHE_SIZE),
+        .DICT_PREFETCH(DICT_PREFETCH),
+        .NUM_ENGINES(NUM_ENGINES),
+        .FILL_DMA(FILL_DMA),
+        .SPI_MAX_SELECT_CYCLES(SPI_MAX_SELECT_CYCLES),
+        .SHARED_BUS(SHARED_BUS)
+    )
+`endif
+    user_project (
 
         // Include power ports for the Gate Level test:
 `ifdef GL_TEST
@@ -1,9 +1,11 @@
 # SPDX-FileCopyrightText: © 2024 Tiny Tapeout
 # SPDX-License-Identifier: Apache-2.0
 
+import os
+
 import cocotb
 from cocotb.clock import Clock
-from cocotb.triggers import ClockCycles, Edge, FallingEdge, Timer
+from cocotb.triggers import ClockCycles, Edge, FallingEdge, RisingEdge, Timer
 
 
 class Uart(object):
@@ -137,6 +139,65 @@ class UARTWishbone(object):
         return await self._transport.recv()
 
 
+class SelectMonitor(object):
+    # Follows SS# of the SRAM on the primary CS pin, counting selects and the shortest time it is high between them
+    def __init__(self, dut):
+        self._dut = dut
+        self.selects = 0
+        self.min_deselect_cycles = None
+        cocotb.start_soon(self._run())
+
+    async def _run(self):
+        previous = 1
+        high_cycles = None
+        while True:
+            await RisingEdge(self._dut.clk)
+            if not self._dut.uio_out[0].value.is_resolvable:
+                continue
+
+            ss_n = int(self._dut.uio_out[0].value)
+            if ss_n == 1:
+                if high_cycles is not None:
+                    high_cycles += 1
+            else:
+                if previous == 1:
+                    self.selects += 1
+                    if high_cycles is not None and (self.min_deselect_cycles is None or high_cycles < self.min_deselect_cycles):
+                        self.min_deselect_cycles = high_cycles
+                high_cycles = 0
+            previous = ss_n
+
+
+def parameter(name: str) -> int:
+    # Parameters of the tb for the current CONFIG, as exported by the Makefile
+    for assignment in os.environ.get("TB_PARAMETERS", "").split():
+        key, value = assignment.split("=")
+        if key == name:
+            return int(value)
+    return 1 if name == "NUM_ENGINES" else 0
+
+
+def levenshtein(s: str, t: str) -> int:
+    row = list(range(len(t) + 1))
+    for i in range(1, len(s) + 1):
+        previous = row
+        row = [i] + [0] * len(t)
+        for j in range(1, len(t) + 1):
+            cost = 0 if s[i - 1] == t[j - 1] else 1
+            row[j] = min(previous[j] + 1, row[j - 1] + 1, previous[j - 1] + cost)
+    return row[len(t)]
+
+
+def best_match(words, search_word: str):
+    # Like the engine, the first word with the lowest distance wins
+    best = None
+    for idx, word in enumerate(words):
+        distance = levenshtein(search_word, word)
+        if best is None or distance < best[1]:
+            best = (idx, distance)
+    return best
+
+
 class Accelerator(object):
     CTRL_ADDR = 0
     SRAM_CTRL_ADDR = 1
@@ -144,11 +205,34 @@ class Accelerator(object):
     MAX_LENGTH_ADDR = 3
     INDEX_ADDR = 4
     DISTANCE_ADDR = 6
+    PREFIX_DEPTH_ADDR = 7
+    CYCLES_ADDR = 8
+    DICT_STALLS_ADDR = 12
+    VECTOR_STALLS_ADDR = 16
+    DICT_BYTES_ADDR = 20
+    WORDS_ADDR = 24
+    VECTOR_CACHE_ADDR = 28
+    ENGINES_ADDR = 29
+    ENGINE_ADDR = 30
+    FILL_ADDR = 31
 
     ENABLE_FLAG = 1
+    PREFIX_FLAG = 2
+    VECTOR_CACHE_FLAG = 4
+
+    FILL_ENGINE_FLAG = 1
+    FILL_BUSY_FLAG = 2
+    FILL_REJECTED_FLAG = 4
+
+    WORD_TERMINATOR = 0x00
+    LIST_TERMINATOR = 0x01
+    PREFIX_HEADER_OFFSET = 0x02
+
+    BURST_SIZE = 4
 
     def __init__(self, bus):
         self._bus = bus
+        self._partition_size = 1
 
     async def init(self, sram_select: int):
         self._max_length = await self._bus.read(self.MAX_LENGTH_ADDR) + 1
@@ -166,6 +250,10 @@ class Accelerator(object):
         else:
             self._bitvector_alignment = 1
 
+        self.prefix_depth = await self._bus.read(self.PREFIX_DEPTH_ADDR)
+        self.vector_cache_size = await self._bus.read(self.VECTOR_CACHE_ADDR)
+        self.engines = await self._bus.read(self.ENGINES_ADDR)
+
         vectormap_size = 256 * self._bitvector_alignment
         self._vectormap_base_addr = vectormap_size
         self._dictionary_base_addr = vectormap_size * 2
@@ -175,43 +263,68 @@ class Accelerator(object):
             for j in range(0, self._bitvector_size // 8):
                 await self._bus.write(self._vectormap_base_addr + i * self._bitvector_alignment + j, 0)
 
-    async def load_dictionary(self, words):
+    def dictionary_image(self, words, front_coding=False):
+        # The same layouts as the client builds
+        if self.engines > 1:
+            return self._partitioned_image(words)
+
+        image = []
+        previous = ""
+        for word in words:
+            if front_coding:
+                shared = 0
+                while shared < min(len(word), len(previous), self.prefix_depth) and word[shared] == previous[shared]:
+                    shared += 1
+                image.append(shared + self.PREFIX_HEADER_OFFSET)
+                image.extend(ord(c) for c in word[shared:])
+                previous = word
+            else:
+                image.extend(ord(c) for c in word)
+            image.append(self.WORD_TERMINATOR)
+        image.append(self.LIST_TERMINATOR)
+        return image
+
+    def _partitioned_image(self, words):
+        partitions = [[] for _ in range(self.engines)]
+        for idx, word in enumerate(words):
+            partition = partitions[idx // self._partition_size]
+            partition.extend(ord(c) for c in word)
+            partition.append(self.WORD_TERMINATOR)
+
+        length = max(len(partition) + 1 for partition in partitions)
+        image = [self.LIST_TERMINATOR] * (length * self.engines)
+        for engine, partition in enumerate(partitions):
+            for i, value in enumerate(partition):
+                image[i * self.engines + engine] = value
+        return image
+
+    async def load_dictionary(self, words, front_coding=False):
         assert (await self._bus.read(self.CTRL_ADDR) & self.ENABLE_FLAG) == 0
 
+        self._partition_size = max((len(words) + self.engines - 1) // self.engines, 1)
         address = self._dictionary_base_addr
-        for word in words:
-            for c in word:
-                await self._bus.write(address, ord(c))
-                address += 1
-            await self._bus.write(address, 0x00)
+        for value in self.dictionary_image(words, front_coding):
+            await self._bus.write(address, value)
             address += 1
-        await self._bus.write(address, 0x01)
 
-    async def verify_dictionary(self, words) -> bool:
+    async def verify_dictionary(self, words, front_coding=False) -> bool:
         assert (await self._bus.read(self.CTRL_ADDR) & self.ENABLE_FLAG) == 0
 
         address = self._dictionary_base_addr
-        for word in words:
-            for c in word:
-                b = await self._bus.read(address)
-                if b != ord(c):
-                    return False
-                address += 1
-
-            b = await self._bus.read(address)
-            if b != 0:
+        for value in self.dictionary_image(words, front_coding):
+            if await self._bus.read(address) != value:
                 return False
-
             address += 1
+        return True
 
-        b = await self._bus.read(address)
-        return b == 0x01
-
-    async def search(self, search_word: str):
+    async def search(self, search_word: str, front_coding=False, use_cache=False, poll_interval=100):
         assert (await self._bus.read(self.CTRL_ADDR) & self.ENABLE_FLAG) == 0
         assert len(search_word) > 0
         assert len(search_word) <= self._max_length
 
+        # Multiple engines always take their bitvectors from the cache
+        use_cache = use_cache or self.engines > 1
+
         vector_map = {}
         for c in search_word:
             vector = 0
@@ -220,19 +333,34 @@ class Accelerator(object):
                     vector |= (1 << i)
             vector_map[c] = vector
 
+        # Writing the length also empties the vector cache, so it goes first
+        await self._bus.write(self.LENGTH_ADDR, len(search_word) - 1)
+
         for c, vector in vector_map.items():
+            if use_cache:
+                await self._bus.write(self.VECTOR_CACHE_ADDR, ord(c))
             for i in range(0, self._bitvector_size // 8):
                 val = (vector >> (self._bitvector_size - 8 - i * 8)) & 0xFF
-                if val != 0:
+                if use_cache:
+                    await self._bus.write(self.VECTOR_CACHE_ADDR, val)
+                elif val != 0:
                     await self._bus.write(self._vectormap_base_addr + ord(c) * self._bitvector_alignment + i, val)
 
-        await self._bus.write(self.LENGTH_ADDR, len(search_word) - 1)
-        await self._bus.write(self.CTRL_ADDR, self.ENABLE_FLAG)
+        control = self.ENABLE_FLAG
+        if front_coding:
+            control |= self.PREFIX_FLAG
+        if use_cache:
+            control |= self.VECTOR_CACHE_FLAG
+        await self._bus.write(self.CTRL_ADDR, control)
 
-        assert (await self._bus.read(self.CTRL_ADDR) & self.ENABLE_FLAG) == self.ENABLE_FLAG
+        # Without the cache, the search is still running when CTRL is read back
+        if not use_cache:
+            assert (await self._bus.read(self.CTRL_ADDR) & self.ENABLE_FLAG) == self.ENABLE_FLAG
 
-        for i in range(0, 20):
-            await Timer(100, units="us")
+        # A poll_interval of 0 reads CTRL back to back, as often as the SPI bus allows
+        for i in range(0, 100 if poll_interval != 0 else 10000):
+            if poll_interval != 0:
+                await Timer(poll_interval, units="us")
 
             ctrl = await self._bus.read(self.CTRL_ADDR)
             if (ctrl & self.ENABLE_FLAG) == 0:
@@ -240,11 +368,12 @@ class Accelerator(object):
 
         assert (ctrl & self.ENABLE_FLAG) == 0
 
-        for c in vector_map.keys():
-            for i in range(0, self._bitvector_size // 8):
-                val = (vector >> (self._bitvector_size - 8 - i * 8)) & 0xFF
-                if val != 0:
-                    await self._bus.write(self._vectormap_base_addr + ord(c) * self._bitvector_alignment + i, 0x00)
+        if not use_cache:
+            for c, vector in vector_map.items():
+                for i in range(0, self._bitvector_size // 8):
+                    val = (vector >> (self._bitvector_size - 8 - i * 8)) & 0xFF
+                    if val != 0:
+                        await self._bus.write(self._vectormap_base_addr + ord(c) * self._bitvector_alignment + i, 0x00)
 
         distance = await self._bus.read(self.DISTANCE_ADDR)
 
@@ -252,14 +381,54 @@ class Accelerator(object):
         idx_lo = await self._bus.read(self.INDEX_ADDR + 1)
 
         idx = (idx_hi << 8) | idx_lo
+        if self.engines > 1:
+            # The index is relative to the partition of the engine which found the match
+            idx += await self._bus.read(self.ENGINE_ADDR) * self._partition_size
 
         return (idx, distance)
 
-
-@cocotb.test()
-async def test_project(dut):
-    dut._log.info("Start")
-
+    async def fill(self, address: int, length: int, value: int):
+        # Only writes the command. The fill runs in the background until the busy flag is cleared
+        for byte in [(address >> 16) & 0xFF, (address >> 8) & 0xFF, address & 0xFF,
+                     (length >> 16) & 0xFF, (length >> 8) & 0xFF, length & 0xFF, value]:
+            await self._bus.write(self.FILL_ADDR, byte)
+
+    async def fill_status(self) -> int:
+        return await self._bus.read(self.FILL_ADDR)
+
+    async def wait_for_fill(self):
+        for i in range(0, 100):
+            status = await self.fill_status()
+            if (status & self.FILL_BUSY_FLAG) == 0:
+                return status
+            await Timer(10, units="us")
+        assert False, "Fill did not complete"
+
+    async def read_counters(self):
+        counters = {}
+        for name, address, size in [
+            ("cycles", self.CYCLES_ADDR, 4),
+            ("dict_stalls", self.DICT_STALLS_ADDR, 4),
+            ("vector_stalls", self.VECTOR_STALLS_ADDR, 4),
+            ("dict_bytes", self.DICT_BYTES_ADDR, 4),
+            ("words", self.WORDS_ADDR, 4)
+        ]:
+            value = 0
+            for i in range(0, size):
+                value = (value << 8) | await self._bus.read(address + i)
+            counters[name] = value
+        return counters
+
+
+# Sorted, so that front coding has prefixes to share
+WORDS = sorted([
+    "h", "he", "hes", "hest", "heste", "hesten", "hestene", "hus", "huse", "husene", "hund", "hunde", "hunden",
+    "kat", "kath", "katte", "katten", "ko", "koen", "kone", "konen"
+])
+SEARCH_WORDS = ["hest", "husen", "hundes", "katen", "ko", "x", "kaffe", "hestenes"]
+
+
+async def start(dut) -> Accelerator:
     clock = Clock(dut.clk, 20, units="ns")
     cocotb.start_soon(clock.start())
 
@@ -272,14 +441,20 @@ async def test_project(dut):
     await ClockCycles(dut.clk, 10)
     dut.rst_n.value = 1
 
-    dut._log.info("Test project behavior")
-
     await ClockCycles(dut.clk, 10)
 
     #uart = Uart(dut)
     wishbone = SPIWishbone(dut, period=80, period_units="ns")
-    accel = Accelerator(wishbone)
+    return Accelerator(wishbone)
+
 
+@cocotb.test()
+async def test_project(dut):
+    dut._log.info("Start")
+
+    accel = await start(dut)
+
+    dut._log.info("Test project behavior")
 
     dictionary = ["h", "he", "hes", "hest", "heste", "hesten"]
 
@@ -292,6 +467,18 @@ async def test_project(dut):
     assert result[0] == 3
     assert result[1] == 0
 
+    # The engine reads whole bursts, and with prefetching it may have fetched the burst after the last one
+    dict_bytes = (len(accel.dictionary_image(dictionary)) + accel.BURST_SIZE - 1) // accel.BURST_SIZE * accel.BURST_SIZE
+
+    counters = await accel.read_counters()
+    dut._log.info(f"Counters: {counters}")
+    assert counters["words"] == len(dictionary)
+    if parameter("DICT_PREFETCH") != 0:
+        assert dict_bytes <= counters["dict_bytes"] <= dict_bytes + accel.BURST_SIZE
+    else:
+        assert counters["dict_bytes"] == dict_bytes
+    assert counters["cycles"] > counters["dict_stalls"] + counters["vector_stalls"]
+
     await accel.init(2)
     await accel.load_dictionary(dictionary)
     assert not await accel.verify_dictionary(dictionary)
@@ -301,4 +488,163 @@ async def test_project(dut):
     assert not await accel.verify_dictionary(dictionary)
 
 
+@cocotb.test()
+async def test_search_words(dut):
+    accel = await start(dut)
+    await accel.init(1)
+    assert accel.engines == parameter("NUM_ENGINES")
+    await accel.load_dictionary(WORDS)
+
+    for search_word in SEARCH_WORDS:
+        assert await accel.search(search_word) == best_match(WORDS, search_word)
+
+
+@cocotb.test()
+async def test_front_coding(dut):
+    accel = await start(dut)
+    await accel.init(1)
+
+    # The prefix stack is left out of multi-engine builds
+    prefix_depth = parameter("PREFIX_STACK_DEPTH") if parameter("NUM_ENGINES") == 1 else 0
+    assert accel.prefix_depth == prefix_depth
+    if prefix_depth == 0:
+        dut._log.info("Skipped, built without the prefix stack")
+        return
+
+    await accel.load_dictionary(WORDS)
+    plain = [await accel.search(search_word) for search_word in SEARCH_WORDS]
+
+    await accel.load_dictionary(WORDS, front_coding=True)
+    assert await accel.verify_dictionary(WORDS, front_coding=True)
+
+    for search_word, expected in zip(SEARCH_WORDS, plain):
+        assert expected == best_match(WORDS, search_word)
+        assert await accel.search(search_word, front_coding=True) == expected
+
+
+@cocotb.test()
+async def test_vector_cache(dut):
+    if parameter("VECTOR_CACHE_SIZE") == 0:
+        dut._log.info("Skipped, built without the vector cache")
+        return
+
+    accel = await start(dut)
+    await accel.init(1)
+    assert accel.vector_cache_size == parameter("VECTOR_CACHE_SIZE")
+
+    await accel.load_dictionary(WORDS)
+    plain = [await accel.search(search_word) for search_word in SEARCH_WORDS]
+
+    for search_word, expected in zip(SEARCH_WORDS, plain):
+        assert expected == best_match(WORDS, search_word)
+        assert await accel.search(search_word, use_cache=True) == expected
+
+
+@cocotb.test()
+async def test_throughput(dut):
+    # Run in every CONFIG, so that the engine cycles of e.g. the default and the prefetch builds can be compared
+    accel = await start(dut)
+    await accel.init(1)
+
+    words = WORDS * 4
+    await accel.load_dictionary(words)
+
+    # With the vector cache, the engine reads nothing but the dictionary from SRAM. Polling as fast as possible shows
+    # what polling costs the engine, which is nothing unless the registers share the SRAM arbiter (SHARED_BUS)
+    use_cache = accel.vector_cache_size > 0
+    for search_word in SEARCH_WORDS[:2]:
+        for poll_interval in [100, 0]:
+            assert await accel.search(search_word, use_cache=use_cache, poll_interval=poll_interval) == best_match(words, search_word)
+
+            counters = await accel.read_counters()
+            dut._log.info(
+                f"{os.environ.get('CONFIG', 'default')}, polling every {poll_interval} us: {counters['cycles']} cycles "
+                f"for {counters['dict_bytes']} dictionary bytes, {counters['cycles'] / counters['dict_bytes']:.2f} cycles "
+                f"per dictionary byte, {counters['dict_stalls']} dictionary stalls, {counters['vector_stalls']} vector stalls")
 
+
+@cocotb.test()
+async def test_fill(dut):
+    accel = await start(dut)
+    await accel.init(1)
+
+    assert ((await accel.fill_status() & accel.FILL_ENGINE_FLAG) != 0) == (parameter("FILL_DMA") != 0)
+    if parameter("FILL_DMA") == 0:
+        dut._log.info("Skipped, built without the fill engine")
+        return
+
+    # An unaligned region crossing fill bursts, between bytes which must be left alone
+    address = accel._dictionary_base_addr + 0x1005
+    length = 70
+    await accel._bus.write(address - 1, 0x11)
+    await accel._bus.write(address + length, 0x22)
+
+    await accel.fill(address, length, 0x5A)
+    assert (await accel.wait_for_fill() & accel.FILL_REJECTED_FLAG) == 0
+
+    assert await accel._bus.read(address - 1) == 0x11
+    for i in range(0, length):
+        assert await accel._bus.read(address + i) == 0x5A
+    assert await accel._bus.read(address + length) == 0x22
+
+    # A command written while a fill is running is refused as a whole
+    await accel.fill(address + 0x1000, 2000, 0x33)
+    await accel.fill(address, length, 0x44)
+    status = await accel.fill_status()
+    assert (status & accel.FILL_BUSY_FLAG) != 0
+    assert (status & accel.FILL_REJECTED_FLAG) != 0
+    assert (await accel.fill_status() & accel.FILL_REJECTED_FLAG) == 0
+    assert (await accel.wait_for_fill() & accel.FILL_REJECTED_FLAG) == 0
+
+    assert await accel._bus.read(address) == 0x5A
+    assert await accel._bus.read(address + 0x1000 + 1999) == 0x33
+
+    # Once the rejected flag has been read, the whole command can be written again
+    await accel.fill(address, length, 0x44)
+    assert (await accel.wait_for_fill() & accel.FILL_REJECTED_FLAG) == 0
+    for i in range(0, length):
+        assert await accel._bus.read(address + i) == 0x44
+
+    # A search started while a fill is running waits for it instead of being dropped
+    await accel.load_dictionary(WORDS)
+    await accel.fill(address + 0x1000, 2000, 0x55)
+    assert await accel.search("hest") == best_match(WORDS, "hest")
+    assert (await accel.fill_status() & accel.FILL_BUSY_FLAG) == 0
+    assert await accel._bus.read(address + 0x1000) == 0x55
+
+
+@cocotb.test()
+async def test_streaming(dut):
+    if parameter("SPI_MAX_SELECT_CYCLES") == 0:
+        dut._log.info("Skipped, built without streaming reads")
+        return
+
+    accel = await start(dut)
+    monitor = SelectMonitor(dut)
+    await accel.init(1)
+    await accel.load_dictionary(WORDS)
+
+    # Reads of consecutive addresses continue the same stream for as long as it may last. The host reads are some 200
+    # cycles apart, so at least the read right after each select fits in SPI_MAX_SELECT_CYCLES, and streams also end
+    # at page boundaries
+    image = accel.dictionary_image(WORDS)
+    selects = monitor.selects
+    assert await accel.verify_dictionary(WORDS)
+    dut._log.info(f"{monitor.selects - selects} selects to read {len(image)} dictionary bytes")
+    assert monitor.selects - selects <= (len(image) + 1) // 2 + len(image) // 1024 + 1
+
+    # A read of any other address breaks the stream and selects the chip again, and a read of the next address
+    # continues the new stream
+    for offset in [0, 40, 3, 2]:
+        selects = monitor.selects
+        assert await accel._bus.read(accel._dictionary_base_addr + offset) == image[offset]
+        assert monitor.selects == selects + 1
+        assert await accel._bus.read(accel._dictionary_base_addr + offset + 1) == image[offset + 1]
+        assert monitor.selects == selects + 1
+
+    # The engine streams consecutive dictionary bursts, which are broken by the bitvector reads
+    for search_word in SEARCH_WORDS:
+        assert await accel.search(search_word) == best_match(WORDS, search_word)
+
+    dut._log.info(f"SS# was high for at least {monitor.min_deselect_cycles} cycles between selects")
+    assert monitor.min_deselect_cycles >= 2